@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef BOUNDARYFILE_H
+#define BOUNDARYFILE_H
+
+#include "FoamFile.h"
+#include "FoamTypes.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A class for reading OpenFOAM polyBoundaryMesh (boundary) files.
+*/
+class BoundaryFile : public FoamFile {
+public:
+
+    //! A single boundary patch entry
+    struct Patch {
+        std::string     name;       //!< The patch name
+        std::string     type;       //!< The patch type (patch, wall, ...)
+        FOAM_UINT32     nFaces;     //!< The number of patch faces
+        FOAM_UINT32     startFace;  //!< The index of the first patch face
+    };
+
+    typedef std::vector<Patch>  PatchArray1;
+
+    BoundaryFile(const char *baseName) :
+        FoamFile(baseName),
+        numPatches_(0)
+    {
+    }
+
+    virtual ~BoundaryFile()
+    {
+    }
+
+
+    //! \return The number of patches in this file.
+    inline FOAM_UINT32  getNumPatches() const {
+                            return numPatches_; }
+
+
+    //! Reads all patch entries.
+    bool
+    readPatches(PatchArray1 &patches)
+    {
+        // afterReadHeader() leaves the file pos on the char AFTER the first (.
+        //
+        // HEADER
+        // 6            // afterReadHeader() reads this value into numPatches_
+        // (            // then reads and discards the (
+        //     inlet    // patch name
+        //     {
+        //         type            patch;
+        //         nFaces          50;
+        //         startFace       10325;
+        //     }
+        //     ...snip...
+        // )
+        // EOF
+        patches.clear();
+        bool ret = true;
+        std::string key;
+        std::string val;
+        for (FOAM_UINT32 ii = 0; ii < numPatches_ && ret; ++ii) {
+            Patch patch = { std::string(), std::string(), 0, 0 };
+            ret = wspaceCommentsSkip() && readToken(patch.name) &&
+                wspaceSkipToChar('{') && wspaceCommentsSkip() &&
+                readToken(key);
+            while (ret && ("}" != key)) {
+                ret = readUntilTrim(val, ';');
+                if (!ret) {
+                    break;
+                }
+                if ("type" == key) {
+                    patch.type = val;
+                }
+                else if ("nFaces" == key) {
+                    patch.nFaces = toUInt32(val);
+                }
+                else if ("startFace" == key) {
+                    patch.startFace = toUInt32(val);
+                }
+                ret = wspaceCommentsSkip() && readToken(key);
+            }
+            if (ret) {
+                patches.push_back(patch);
+            }
+        }
+        return ret;
+    }
+
+private:
+
+    static FOAM_UINT32
+    toUInt32(const std::string &val)
+    {
+        return static_cast<FOAM_UINT32>(std::strtoul(val.c_str(), 0, 10));
+    }
+
+
+    //! Validate header values, capture total patch count, leave file pos on
+    //! first char after (, and re-mark data begin position.
+    virtual bool
+    afterReadHeader()
+    {
+        return headerValIs("class", "polyBoundaryMesh") &&
+            readInt(numPatches_) && wspaceSkipToChar('(') && markBeginData();
+    }
+
+
+private:
+    FOAM_UINT32  numPatches_;    //!< The number of patches in the file
+};
+
+#endif // BOUNDARYFILE_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,264 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef CELLFACECSR_H
+#define CELLFACECSR_H
+
+#include "FoamArena.h"
+#include "FoamParallel.h"
+#include "FoamTypes.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The faces of each cell in compressed sparse row form.
+
+    The faces of cell c are getFace(k) for k in [getBegin(c), getEnd(c)) in
+    ascending face order. The adjacency is built from the OpenFOAM owner and
+    neighbour labels with a parallel counting sort. The faces are split into
+    one range per thread. Each range counts the faces of every cell in its
+    own histogram row. A prefix sum over the cells and rows then gives each
+    range its own slots in each cell, and each range fills its slots. Each
+    pass visits every face once, no locking is needed and the result does
+    not depend on the thread count.
+
+    The histogram rows never use more memory than the adjacency itself. So,
+    meshes with few faces per cell use fewer ranges.
+
+    The adjacency is stored in the arena if one is given. The histogram is
+    freed by build(), so it is always on the heap.
+*/
+class CellFaceCsr {
+
+    typedef FoamLabelArray1     UInt32Array1;
+
+public:
+
+    CellFaceCsr(FoamArena *arena = 0) :
+        offsets_(FoamArenaAllocator<FOAM_UINT32>(arena)),
+        faces_(FoamArenaAllocator<FOAM_UINT32>(arena))
+    {
+    }
+
+    ~CellFaceCsr()
+    {
+    }
+
+
+    /*! Builds the adjacency.
+        owners has one label per face. neighbors has one label per interior
+        face. A neighbor of FOAM_UINT32_MAX marks a boundary face. The cell
+        count is one more than the largest label.
+        \return false if the mesh is too large for 32 bit offsets, the
+        memory cannot be allocated or the build was cancelled.
+    */
+    bool
+    build(const UInt32Array1 &owners, const UInt32Array1 &neighbors)
+    {
+        offsets_.clear();
+        faces_.clear();
+        bool ret;
+        try {
+            ret = buildAdjacency(owners, neighbors);
+        }
+        catch (const std::bad_alloc &) {
+            ret = false;
+        }
+        if (!ret) {
+            offsets_.clear();
+            faces_.clear();
+        }
+        return ret;
+    }
+
+
+    //! \return The number of cells.
+    inline FOAM_UINT32  getNumCells() const {
+                            return offsets_.empty() ? 0 :
+                                static_cast<FOAM_UINT32>(offsets_.size() - 1); }
+
+    //! \return The index of the first face of cell.
+    inline FOAM_UINT32  getBegin(FOAM_UINT32 cell) const {
+                            return offsets_[cell]; }
+
+    //! \return One past the index of the last face of cell.
+    inline FOAM_UINT32  getEnd(FOAM_UINT32 cell) const {
+                            return offsets_[cell + 1]; }
+
+    //! \return The face at index ndx.
+    inline FOAM_UINT32  getFace(FOAM_UINT32 ndx) const {
+                            return faces_[ndx]; }
+
+private:
+
+    //! Builds the adjacency. Allocations may throw std::bad_alloc.
+    //! \return false if the mesh is too large or the build was cancelled.
+    bool
+    buildAdjacency(const UInt32Array1 &owners, const UInt32Array1 &neighbors)
+    {
+        const FOAM_UINT64 numFaces = owners.size();
+        const FOAM_UINT64 numNbors = neighbors.size();
+        FOAM_UINT64 numCells = 0;
+        bool ret = (numNbors <= numFaces) &&
+            ((numFaces + numNbors) < FOAM_UINT32_MAX) &&
+            findNumCells(owners, neighbors, numCells);
+        if (!ret) {
+            return false;
+        }
+
+        // Limit the rows so they are no larger than faces_
+        const FOAM_UINT64 maxRows = std::max<FOAM_UINT64>(1,
+            std::min<FOAM_UINT64>(foamNumThreads(),
+                (numFaces + numNbors) / std::max<FOAM_UINT64>(1, numCells)));
+        const FOAM_UINT64 grain = std::max(foamTaskGrain("adjacency", 4096),
+            (numFaces + maxRows - 1) / maxRows);
+        std::vector<FOAM_UINT32> hist(static_cast<size_t>(maxRows * numCells));
+
+        // Count the faces of each cell in the row of each range
+        const FOAM_UINT32 numRows = foamParallelFor(numFaces,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT32 *cnt = &hist[0] + rng * numCells;
+            for (FOAM_UINT64 ff = beg; ff < end; ++ff) {
+                ++cnt[owners[ff]];
+                if ((ff < numNbors) && (FOAM_UINT32_MAX != neighbors[ff])) {
+                    ++cnt[neighbors[ff]];
+                }
+            }
+        }, grain);
+        if ((0 == numRows) || !prefixSum(&hist[0], numRows, numCells)) {
+            // Cancelled
+            return false;
+        }
+
+        // Each range fills its slots of each cell. This uses the same ranges
+        // as the count.
+        faces_.resize(offsets_.back());
+        return 0 != foamParallelFor(numFaces, [&](FOAM_UINT64 beg,
+                FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT32 *next = &hist[0] + rng * numCells;
+            for (FOAM_UINT64 ff = beg; ff < end; ++ff) {
+                const FOAM_UINT32 face = static_cast<FOAM_UINT32>(ff);
+                faces_[next[owners[ff]]++] = face;
+                if ((ff < numNbors) && (FOAM_UINT32_MAX != neighbors[ff])) {
+                    faces_[next[neighbors[ff]]++] = face;
+                }
+            }
+        }, grain);
+    }
+
+
+
+    //! Finds the cell count from the largest owner or neighbor. A cell
+    //! that only has interior faces may never be an owner.
+    //! \return false if a label is too large or the search was cancelled.
+    static bool
+    findNumCells(const UInt32Array1 &owners, const UInt32Array1 &neighbors,
+        FOAM_UINT64 &numCells)
+    {
+        const FOAM_UINT64 numNbors = neighbors.size();
+        std::vector<FOAM_UINT64> maxCells(foamNumThreads(), 0);
+        const FOAM_UINT32 numRanges = foamParallelFor(owners.size(),
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT64 cnt = 0;
+            for (FOAM_UINT64 ff = beg; ff < end; ++ff) {
+                cnt = std::max<FOAM_UINT64>(cnt, owners[ff] + FOAM_UINT64(1));
+                if ((ff < numNbors) && (FOAM_UINT32_MAX != neighbors[ff])) {
+                    cnt = std::max<FOAM_UINT64>(cnt,
+                        neighbors[ff] + FOAM_UINT64(1));
+                }
+            }
+            maxCells[rng] = cnt;
+        }, foamTaskGrain("adjacency", 4096));
+        numCells = 0;
+        for (FOAM_UINT32 ii = 0; ii < numRanges; ++ii) {
+            numCells = std::max(numCells, maxCells[ii]);
+        }
+        return (0 != numRanges) && (numCells < FOAM_UINT32_MAX);
+    }
+
+
+    /*! Sets offsets_ from the counts of numRows histogram rows and replaces
+        each count with the first slot of that row in that cell. The rows of
+        a cell take their slots in row order.
+        \return false if cancelled.
+    */
+    bool
+    prefixSum(FOAM_UINT32 *hist, FOAM_UINT32 numRows, FOAM_UINT64 numCells)
+    {
+        // Sum the counts of each range of cells
+        const FOAM_UINT64 grain = foamTaskGrain("adjacency", 4096);
+        std::vector<FOAM_UINT32> rangeSum(foamNumThreads(), 0);
+        const FOAM_UINT32 numRanges = foamParallelFor(numCells,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT32 sum = 0;
+            for (FOAM_UINT64 cc = beg; cc < end; ++cc) {
+                for (FOAM_UINT32 rr = 0; rr < numRows; ++rr) {
+                    sum += hist[rr * numCells + cc];
+                }
+            }
+            rangeSum[rng] = sum;
+        }, grain);
+        FOAM_UINT32 total = 0;
+        for (FOAM_UINT32 ii = 0; ii < numRanges; ++ii) {
+            const FOAM_UINT32 sum = rangeSum[ii];
+            rangeSum[ii] = total;
+            total += sum;
+        }
+        offsets_.resize(static_cast<size_t>(numCells) + 1);
+        offsets_.back() = total;
+        // Each range of cells continues from the sum of the ranges before it
+        return (0 != numRanges) && (0 != foamParallelFor(numCells,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT32 pos = rangeSum[rng];
+            for (FOAM_UINT64 cc = beg; cc < end; ++cc) {
+                offsets_[cc] = pos;
+                for (FOAM_UINT32 rr = 0; rr < numRows; ++rr) {
+                    FOAM_UINT32 &slot = hist[rr * numCells + cc];
+                    const FOAM_UINT32 cnt = slot;
+                    slot = pos;
+                    pos += cnt;
+                }
+            }
+        }, grain));
+    }
+
+private:
+    CellFaceCsr(const CellFaceCsr&);
+    const CellFaceCsr& operator=(const CellFaceCsr&);
+
+private:
+    UInt32Array1    offsets_;   //!< The first face index of each cell
+    UInt32Array1    faces_;     //!< The faces of all cells
+};
+
+#endif // CELLFACECSR_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
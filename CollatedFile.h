@@ -0,0 +1,188 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef COLLATEDFILE_H
+#define COLLATEDFILE_H
+
+#include "FoamBuffer.h"
+#include "FoamTypes.h"
+
+#include <string>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A class for indexing OpenFOAM collated (decomposedBlockData) files.
+
+    A collated file holds the data of every processor rank as a sequence of
+    character blocks. Each block is prefixed by its size in bytes. open()
+    indexes the blocks from these sizes without parsing their contents. The
+    blocks can then be parsed independently, and in any order, with the
+    FoamBuffer returned by getBlock().
+
+    In a binary file, the lists in the blocks hold raw labels and scalars
+    with the sizes given by the header's arch entry.
+*/
+class CollatedFile {
+
+    struct Block {
+        const char *    begin;  //!< The first data byte of the block
+        const char *    end;    //!< One past the last data byte of the block
+    };
+
+    typedef std::vector<Block>  BlockArray1;
+
+public:
+
+    CollatedFile(const char *baseName) :
+        file_(),
+        hdrVals_(),
+        baseName_(baseName),
+        blocks_(),
+        binary_(false),
+        labelBytes_(4),
+        scalarBytes_(8)
+    {
+    }
+
+    ~CollatedFile()
+    {
+    }
+
+
+    //! Maps the file (in cwd), loads the header data and indexes the blocks.
+    //! \return false if the file is not a valid collated file or is binary
+    //! with another byte order.
+    bool
+    open()
+    {
+        // HEADER       // class decomposedBlockData
+        // // Processor0
+        // 1149         // size of block 0 in bytes
+        // (...)        // 1149 bytes of rank 0 data
+        // // Processor1
+        // 1104         // size of block 1 in bytes
+        // (...)        // 1104 bytes of rank 1 data
+        // EOF
+        blocks_.clear();
+        FoamBuffer buf;
+        bool ret = file_.open(baseName_.c_str());
+        if (ret) {
+            buf = FoamBuffer(file_.begin(), file_.end());
+            ret = buf.readHeader(hdrVals_) &&
+                headerValIs("class", "decomposedBlockData") && readFormat();
+        }
+        while (ret && !buf.atEnd()) {
+            FOAM_UINT32 numBytes;
+            Block blk;
+            ret = buf.readInt(numBytes) && buf.wspaceSkipToChar('(');
+            if (ret) {
+                blk.begin = buf.pos();
+                // The declared size must leave room for the closing paren
+                ret = (numBytes < static_cast<size_t>(buf.end() - blk.begin));
+            }
+            if (ret) {
+                blk.end = blk.begin + numBytes;
+                buf.setPos(blk.end);
+                ret = buf.wspaceSkipToChar(')') && buf.wspaceCommentsSkip();
+            }
+            if (ret) {
+                blocks_.push_back(blk);
+            }
+        }
+        return ret && !blocks_.empty();
+    }
+
+
+    //! \return true if header key exists and is equal to expectedVal.
+    bool
+    headerValIs(const char *key, const char *expectedVal) const
+    {
+        FoamBuffer::StringStringMap::const_iterator it = hdrVals_.find(key);
+        return (hdrVals_.end() != it) && (expectedVal == it->second);
+    }
+
+
+    //! \return true if the blocks hold binary lists.
+    inline bool         isBinary() const {
+                            return binary_; }
+
+    //! \return The size of a binary label.
+    inline size_t       getLabelBytes() const {
+                            return labelBytes_; }
+
+    //! \return The size of a binary scalar.
+    inline size_t       getScalarBytes() const {
+                            return scalarBytes_; }
+
+
+    //! \return The number of indexed blocks (processor ranks).
+    inline FOAM_UINT32  getNumBlocks() const {
+                            return static_cast<FOAM_UINT32>(blocks_.size()); }
+
+
+    //! \return A cursor over the data of block ndx.
+    inline FoamBuffer   getBlock(FOAM_UINT32 ndx) const {
+                            return FoamBuffer(blocks_.at(ndx).begin,
+                                blocks_.at(ndx).end); }
+
+private:
+
+    //! Loads the format and the label and scalar sizes from the header.
+    bool
+    readFormat()
+    {
+        const std::string &arch = hdrVals_["arch"];
+        binary_ = headerValIs("format", "binary");
+        labelBytes_ = (std::string::npos != arch.find("label=64")) ? 8 : 4;
+        scalarBytes_ = (std::string::npos != arch.find("scalar=32")) ? 4 : 8;
+        // Binary data must have the same byte order as this machine
+        const FOAM_UINT32 one = 1;
+        const bool isLsb = (1 == *reinterpret_cast<const unsigned char*>(&one));
+        const bool archLsb = (std::string::npos == arch.find("MSB"));
+        return headerValIs("format", "ascii") ||
+            (binary_ && (isLsb == archLsb));
+    }
+
+private:
+    CollatedFile(const CollatedFile&);
+    const CollatedFile& operator=(const CollatedFile&);
+
+private:
+    FoamMappedFile                  file_;      //!< The mapped file data
+    FoamBuffer::StringStringMap     hdrVals_;   //!< The header key/values
+    std::string                     baseName_;  //!< The file name
+    BlockArray1                     blocks_;    //!< The per rank block index
+    bool                            binary_;    //!< true if format is binary
+    size_t                          labelBytes_; //!< The binary label size
+    size_t                          scalarBytes_; //!< The binary scalar size
+};
+
+#endif // COLLATEDFILE_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
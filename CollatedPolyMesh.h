@@ -0,0 +1,644 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef COLLATEDPOLYMESH_H
+#define COLLATEDPOLYMESH_H
+
+#include "CollatedFile.h"
+#include "FoamBuffer.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "PolyMeshHandler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A class for reading a polyMesh written with "-fileHandler collated".
+
+    The processors<N>/constant/polyMesh folder holds one collated file per
+    polyMesh object. Each file holds a block for every rank. The blocks of
+    all ranks and files are parsed in parallel directly from the mapped file
+    data. The per rank meshes are then merged into the undecomposed mesh with
+    the pointProcAddressing, faceProcAddressing and cellProcAddressing maps.
+*/
+class CollatedPolyMesh {
+
+    //! The collated files used to reconstruct the mesh
+    enum FileId {
+        Points,
+        Faces,
+        Owner,
+        Neighbour,
+        PointAddr,
+        FaceAddr,
+        CellAddr,
+        NumFiles
+    };
+
+    struct Face {
+        FOAM_UINT32  vertCnt;    //!< The number of used index values
+        FOAM_UINT32  index[4];   //!< The face vertex indices
+    };
+
+    typedef std::vector<double>         DoubleArray1;
+    typedef std::vector<Face>           FaceArray1;
+    typedef std::vector<FOAM_INT32>      Int32Array1;
+    typedef std::vector<FOAM_UINT32>     UInt32Array1;
+
+    //! The data parsed from the blocks of a single rank
+    struct RankData {
+        DoubleArray1    xyz;        //!< The local points
+        FaceArray1      faces;      //!< The local faces
+        UInt32Array1    owner;      //!< The local face owner cells
+        UInt32Array1    neighbor;   //!< The local face neighbor cells
+        UInt32Array1    pointAddr;  //!< The local to global point map
+        Int32Array1     faceAddr;   //!< The local to signed, 1-based face map
+        UInt32Array1    cellAddr;   //!< The local to global cell map
+    };
+
+    typedef std::vector<RankData>       RankDataArray1;
+
+public:
+
+    CollatedPolyMesh() :
+        pointsFile_("points"),
+        facesFile_("faces"),
+        ownerFile_("owner"),
+        neighborFile_("neighbour"),
+        pointAddrFile_("pointProcAddressing"),
+        faceAddrFile_("faceProcAddressing"),
+        cellAddrFile_("cellProcAddressing"),
+        ranks_(),
+        xyz_(),
+        faces_(),
+        owner_(),
+        neighbor_(),
+        numInternal_(0)
+    {
+    }
+
+    ~CollatedPolyMesh()
+    {
+    }
+
+
+    //! Opens, parses and merges all collated files. Uses two progress steps.
+    bool
+    read(PolyMeshHandler &handler)
+    {
+        bool ret = openFiles() && parseBlocks(handler) && merge(handler);
+        // Rank data is no longer needed
+        RankDataArray1().swap(ranks_);
+        return ret;
+    }
+
+
+    //! \return The number of merged points.
+    inline FOAM_UINT32  getNumPts() const {
+                            return static_cast<FOAM_UINT32>(xyz_.size() / 3); }
+
+    //! \return The number of merged faces.
+    inline FOAM_UINT32  getNumFaces() const {
+                            return static_cast<FOAM_UINT32>(faces_.size()); }
+
+    //! \return The number of merged interior faces.
+    inline FOAM_UINT32  getNumInternalFaces() const {
+                            return numInternal_; }
+
+
+    //! Gets merged point ndx.
+    inline void
+    getPoint(FOAM_UINT32 ndx, FoamPoint &pt) const
+    {
+        pt.x = xyz_[3 * ndx];
+        pt.y = xyz_[3 * ndx + 1];
+        pt.z = xyz_[3 * ndx + 2];
+    }
+
+
+    //! Gets merged face ndx using the OpenFOAM owner/neighbor convention.
+    inline void
+    getFace(FOAM_UINT32 ndx, FoamFace &data) const
+    {
+        const Face &face = faces_[ndx];
+        data.id = ndx;
+        data.type = (ndx < numInternal_) ? FOAM_FACETYPE_INTERIOR :
+            FOAM_FACETYPE_BOUNDARY;
+        data.owner = owner_[ndx];
+        data.neighbor = neighbor_[ndx];
+        data.vertCnt = face.vertCnt;
+        for (FOAM_UINT32 ii = 0; ii < face.vertCnt; ++ii) {
+            data.index[ii] = face.index[ii];
+        }
+    }
+
+private:
+
+    bool
+    openFiles()
+    {
+        bool ret = pointsFile_.open() && facesFile_.open() &&
+            ownerFile_.open() && neighborFile_.open() &&
+            pointAddrFile_.open() && faceAddrFile_.open() &&
+            cellAddrFile_.open();
+        if (ret) {
+            // All files must have a block for every rank
+            const FOAM_UINT32 numRanks = facesFile_.getNumBlocks();
+            for (int ii = 0; ii < NumFiles; ++ii) {
+                if (numRanks != file(FileId(ii)).getNumBlocks()) {
+                    ret = false;
+                    break;
+                }
+            }
+            ranks_.resize(numRanks);
+        }
+        return ret;
+    }
+
+
+    //! Parses all blocks of all files. The blocks are independent, so each
+    //! (rank, file) pair is a separate task of the current FoamTaskPool. The
+    //! calling thread reports progress as tasks complete and cancels the
+    //! remaining tasks if the user aborts or any task fails.
+    bool
+    parseBlocks(PolyMeshHandler &handler)
+    {
+        const FOAM_UINT32 numTasks =
+            static_cast<FOAM_UINT32>(ranks_.size()) * NumFiles;
+        if (!handler.beginStep(numTasks)) {
+            return false;
+        }
+        std::atomic<FOAM_UINT32> numDone(0);
+        std::atomic<bool> failed(false);
+        FoamCurrentPool current;
+        FoamTaskPool &pool = current.get();
+        FoamTaskPool::Group group;
+        for (FOAM_UINT32 task = 0; task < numTasks; ++task) {
+            pool.run(group, [&, task]() {
+                if (!parseBlock(task / NumFiles, FileId(task % NumFiles))) {
+                    failed = true;
+                    group.cancel();
+                }
+                ++numDone;
+            });
+        }
+
+        FOAM_UINT32 numReported = 0;
+        const bool ok = pool.wait(group, [&]() {
+            // false if aborted
+            const FOAM_UINT32 cnt = numDone;
+            const bool ret = handler.stepIncr(cnt - numReported) &&
+                FoamTaskPool::poll();
+            numReported = cnt;
+            return ret;
+        });
+        return handler.endStep() && ok && !failed;
+    }
+
+
+    //! Parses the block for rank from file fileId into the rank's data.
+    bool
+    parseBlock(FOAM_UINT32 rank, FileId fileId)
+    {
+        // The first block may repeat the header of the uncollated file. The
+        // rest start directly with the list.
+        //
+        // [HEADER]
+        // 68
+        // (
+        //  ...
+        // )
+        RankData &rd = ranks_[rank];
+        const CollatedFile &cf = file(fileId);
+        FoamBuffer buf = cf.getBlock(rank);
+        FoamBuffer::StringStringMap hdrVals;
+        FOAM_UINT32 cnt;
+        bool ret = buf.readOptionalHeader(hdrVals) && buf.readListBegin(cnt);
+        if (ret) {
+            // A bogus count must not allocate more records than the block
+            // can hold. A bad_alloc on a pool thread would terminate.
+            switch (fileId) {
+            case Points:
+                ret = readPoints(buf, cnt, cf, rd.xyz);
+                break;
+            case Faces:
+                ret = readFaces(buf, cnt, cf, rd.faces);
+                break;
+            case Owner:
+                ret = readLabels(buf, cnt, cf, rd.owner);
+                break;
+            case Neighbour:
+                ret = readLabels(buf, cnt, cf, rd.neighbor);
+                break;
+            case PointAddr:
+                ret = readLabels(buf, cnt, cf, rd.pointAddr);
+                break;
+            case FaceAddr:
+                ret = readFaceAddrs(buf, cnt, cf, rd.faceAddr);
+                break;
+            case CellAddr:
+                ret = readLabels(buf, cnt, cf, rd.cellAddr);
+                break;
+            default:
+                ret = false;
+                break;
+            }
+        }
+        // There should be one ) remaining and then the end of the block
+        return ret && buf.readListEnd();
+    }
+
+
+    //! \return true if the rest of buf can hold cnt records of at least
+    //! minBytes chars each.
+    static inline bool
+    fits(const FoamBuffer &buf, FOAM_UINT32 cnt, FOAM_UINT64 minBytes)
+    {
+        return cnt * minBytes <=
+            static_cast<FOAM_UINT64>(buf.end() - buf.pos());
+    }
+
+
+    //! Reads the next binary label of buf. A label has bytes bytes (4 or 8).
+    static inline bool
+    readRawLabel(FoamBuffer &buf, size_t bytes, FOAM_INT64 &val)
+    {
+        const char *p = buf.pos();
+        const bool ret = (bytes <= static_cast<size_t>(buf.end() - p));
+        if (ret && (4 == bytes)) {
+            FOAM_INT32 v;
+            std::memcpy(&v, p, 4);
+            val = v;
+        }
+        else if (ret) {
+            std::memcpy(&val, p, 8);
+        }
+        if (ret) {
+            buf.setPos(p + bytes);
+        }
+        return ret;
+    }
+
+
+    //! Reads the next binary scalar of buf. A scalar has bytes bytes (4 or
+    //! 8).
+    static inline bool
+    readRawScalar(FoamBuffer &buf, size_t bytes, double &val)
+    {
+        const char *p = buf.pos();
+        const bool ret = (bytes <= static_cast<size_t>(buf.end() - p));
+        if (ret && (4 == bytes)) {
+            float v;
+            std::memcpy(&v, p, 4);
+            val = v;
+        }
+        else if (ret) {
+            std::memcpy(&val, p, 8);
+        }
+        if (ret) {
+            buf.setPos(p + bytes);
+        }
+        return ret;
+    }
+
+
+    //! Reads the cnt points of a list whose ( was read.
+    static bool
+    readPoints(FoamBuffer &buf, FOAM_UINT32 cnt, const CollatedFile &cf,
+        DoubleArray1 &xyz)
+    {
+        // each ascii point has the form: "(x y z)"
+        const size_t bytes = cf.getScalarBytes();
+        bool ret = fits(buf, cnt, cf.isBinary() ? 3 * bytes : 7);
+        if (ret) {
+            xyz.resize(3 * static_cast<size_t>(cnt));
+        }
+        for (size_t ii = 0; ii < xyz.size() && ret; ii += 3) {
+            ret = cf.isBinary() ? (readRawScalar(buf, bytes, xyz[ii]) &&
+                readRawScalar(buf, bytes, xyz[ii + 1]) &&
+                readRawScalar(buf, bytes, xyz[ii + 2])) :
+                buf.readVector(xyz[ii], xyz[ii + 1], xyz[ii + 2]);
+        }
+        return ret;
+    }
+
+
+    //! Reads the cnt labels of a list whose ( was read.
+    static bool
+    readLabels(FoamBuffer &buf, FOAM_UINT32 cnt, const CollatedFile &cf,
+        UInt32Array1 &lbls)
+    {
+        const size_t bytes = cf.getLabelBytes();
+        bool ret = fits(buf, cnt, cf.isBinary() ? bytes : 1);
+        if (ret) {
+            lbls.resize(cnt);
+        }
+        FOAM_INT64 val = 0;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            if (cf.isBinary()) {
+                ret = readRawLabel(buf, bytes, val) && (0 <= val) &&
+                    (val <= FOAM_INT64(FOAM_UINT32_MAX));
+                lbls[ii] = static_cast<FOAM_UINT32>(val);
+            }
+            else {
+                ret = buf.readInt(lbls[ii]);
+            }
+        }
+        return ret;
+    }
+
+
+    //! Reads the cnt signed face addresses of a list whose ( was read.
+    static bool
+    readFaceAddrs(FoamBuffer &buf, FOAM_UINT32 cnt, const CollatedFile &cf,
+        Int32Array1 &addrs)
+    {
+        const size_t bytes = cf.getLabelBytes();
+        bool ret = fits(buf, cnt, cf.isBinary() ? bytes : 1);
+        if (ret) {
+            addrs.resize(cnt);
+        }
+        FOAM_INT64 val = 0;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            if (cf.isBinary()) {
+                ret = readRawLabel(buf, bytes, val) &&
+                    (std::numeric_limits<FOAM_INT32>::min() <= val) &&
+                    (val <= std::numeric_limits<FOAM_INT32>::max());
+                addrs[ii] = static_cast<FOAM_INT32>(val);
+            }
+            else {
+                ret = buf.readInt(addrs[ii]);
+            }
+        }
+        return ret;
+    }
+
+
+    /*! Reads the cnt faces of a faceList whose ( was read, or the faces of a
+        faceCompactList. A faceCompactList is a list of cnt offsets into a
+        second list that holds the vertices of all faces. Binary faces are
+        always compact. An ascii faceList is told apart by the ( that follows
+        the vertex count of its first face.
+    */
+    static bool
+    readFaces(FoamBuffer &buf, FOAM_UINT32 cnt, const CollatedFile &cf,
+        FaceArray1 &faces)
+    {
+        FoamBuffer peek = buf;
+        FOAM_UINT32 val;
+        if (!cf.isBinary() && ((0 == cnt) ||
+                (peek.readInt(val) && peek.wspaceSkipToChar('(')))) {
+            // each face has at least the form: "3(a b c)"
+            bool ret = fits(buf, cnt, 8);
+            if (ret) {
+                faces.resize(cnt);
+            }
+            FoamFace data;
+            for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+                ret = foamReadFace(buf, data);
+                faces[ii].vertCnt = data.vertCnt;
+                std::copy(data.index, data.index + 4, faces[ii].index);
+            }
+            return ret;
+        }
+        UInt32Array1 offsets;
+        UInt32Array1 verts;
+        FOAM_UINT32 numVerts = 0;
+        bool ret = readLabels(buf, cnt, cf, offsets) &&
+            buf.wspaceSkipToChar(')') && buf.readListBegin(numVerts) &&
+            readLabels(buf, numVerts, cf, verts) &&
+            (offsets.empty() ? (0 == numVerts) :
+                ((0 == offsets[0]) && (numVerts == offsets.back())));
+        if (ret && !offsets.empty()) {
+            faces.resize(offsets.size() - 1);
+        }
+        for (size_t ii = 0; ii < faces.size() && ret; ++ii) {
+            const FOAM_UINT32 beg = offsets[ii];
+            const FOAM_UINT32 end = offsets[ii + 1];
+            // Only tri and quad faces are supported
+            ret = (beg <= end) && ((3 == end - beg) || (4 == end - beg));
+            if (ret) {
+                faces[ii].vertCnt = end - beg;
+                std::copy(&verts[0] + beg, &verts[0] + end, faces[ii].index);
+            }
+        }
+        return ret;
+    }
+
+
+    //! Merges the per rank data into the global mesh.
+    bool
+    merge(PolyMeshHandler &handler)
+    {
+        const FOAM_UINT32 Unset = FOAM_UINT32_MAX;
+        bool ret = handler.beginStep(
+            static_cast<FOAM_UINT32>(ranks_.size()));
+        // Size the global mesh from the largest global indices
+        FOAM_UINT32 numPts = 0;
+        FOAM_UINT32 numFaces = 0;
+        FOAM_UINT64 sumPts = 0;
+        FOAM_UINT64 sumFaces = 0;
+        for (size_t rr = 0; rr < ranks_.size() && ret; ++rr) {
+            const RankData &rd = ranks_[rr];
+            ret = (3 * rd.pointAddr.size() == rd.xyz.size()) &&
+                (rd.faceAddr.size() == rd.faces.size()) &&
+                (rd.owner.size() == rd.faces.size()) &&
+                (rd.neighbor.size() <= rd.faces.size());
+            sumPts += rd.pointAddr.size();
+            sumFaces += rd.faces.size();
+            // MAX is not a valid index and would wrap the count to 0
+            for (size_t ii = 0; ii < rd.pointAddr.size() && ret; ++ii) {
+                ret = (rd.pointAddr[ii] < FOAM_UINT32_MAX);
+                numPts = ret ? std::max(numPts, rd.pointAddr[ii] + 1) :
+                    numPts;
+            }
+            for (size_t ii = 0; ii < rd.faceAddr.size() && ret; ++ii) {
+                const FOAM_INT32 addr = rd.faceAddr[ii];
+                ret = isFaceAddr(addr);
+                numFaces = ret ? std::max(numFaces, faceIndex(addr) + 1) :
+                    numFaces;
+            }
+        }
+        // Every global point and face is in at least one rank, so a larger
+        // index is a bad address and must not size the global mesh
+        ret = ret && (numPts <= sumPts) && (numFaces <= sumFaces);
+        if (ret) {
+            xyz_.assign(3 * static_cast<size_t>(numPts), 0.0);
+            Face noFace = { 0, { 0, 0, 0, 0 } };
+            faces_.assign(numFaces, noFace);
+            owner_.assign(numFaces, Unset);
+            neighbor_.assign(numFaces, Unset);
+        }
+        for (size_t rr = 0; rr < ranks_.size() && ret; ++rr) {
+            const RankData &rd = ranks_[rr];
+            for (size_t ii = 0; ii < rd.pointAddr.size(); ++ii) {
+                std::copy(&rd.xyz[3 * ii], &rd.xyz[3 * ii] + 3,
+                    &xyz_[3 * static_cast<size_t>(rd.pointAddr[ii])]);
+            }
+            for (size_t ii = 0; ii < rd.faces.size() && ret; ++ii) {
+                ret = mergeFace(rd, ii);
+            }
+            ret = ret && handler.stepIncr(1);
+        }
+        // Global faces are ordered with all interior faces first. Every face
+        // must have an owner. Only the interior faces have a neighbor.
+        numInternal_ = 0;
+        while (ret && (numInternal_ < numFaces) &&
+                (Unset != neighbor_[numInternal_])) {
+            ++numInternal_;
+        }
+        for (FOAM_UINT32 ii = 0; ii < numFaces && ret; ++ii) {
+            ret = (Unset != owner_[ii]) && (0 != faces_[ii].vertCnt) &&
+                ((ii < numInternal_) || (Unset == neighbor_[ii]));
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    //! Maps local face ii of rank rd to its global face. A negative face
+    //! address means the local face is flipped relative to the global face.
+    //! Processor boundary faces appear in two ranks. The rank holding the
+    //! unflipped copy supplies the owner and the other rank supplies the
+    //! neighbor.
+    bool
+    mergeFace(const RankData &rd, size_t ii)
+    {
+        const FOAM_INT32 addr = rd.faceAddr[ii];
+        const FOAM_UINT32 numCells =
+            static_cast<FOAM_UINT32>(rd.cellAddr.size());
+        const FOAM_UINT32 numPts =
+            static_cast<FOAM_UINT32>(rd.pointAddr.size());
+        const Face &lface = rd.faces[ii];
+        bool ret = isFaceAddr(addr) && (rd.owner[ii] < numCells) &&
+            ((ii >= rd.neighbor.size()) || (rd.neighbor[ii] < numCells));
+        for (FOAM_UINT32 jj = 0; jj < lface.vertCnt && ret; ++jj) {
+            ret = (lface.index[jj] < numPts);
+        }
+        if (ret) {
+            const FOAM_UINT32 gndx = faceIndex(addr);
+            const FOAM_UINT32 own = rd.cellAddr[rd.owner[ii]];
+            const bool hasNbor = (ii < rd.neighbor.size());
+            const FOAM_UINT32 nbor = hasNbor ? rd.cellAddr[rd.neighbor[ii]] :
+                FOAM_UINT32_MAX;
+            Face gface;
+            gface.vertCnt = lface.vertCnt;
+            for (FOAM_UINT32 jj = 0; jj < lface.vertCnt; ++jj) {
+                gface.index[jj] = rd.pointAddr[lface.index[jj]];
+            }
+            if (0 < addr) {
+                faces_[gndx] = gface;
+                ret = setOnce(owner_[gndx], own) &&
+                    (!hasNbor || setOnce(neighbor_[gndx], nbor));
+            }
+            else {
+                ret = setOnce(neighbor_[gndx], own);
+                if (ret && hasNbor) {
+                    // keep first vertex and reverse the rest
+                    std::reverse(gface.index + 1, gface.index + gface.vertCnt);
+                    faces_[gndx] = gface;
+                    ret = setOnce(owner_[gndx], nbor);
+                }
+            }
+        }
+        return ret;
+    }
+
+
+    //! \return true if addr is a valid face address. A face address is the
+    //! 1 based global face index, negated if flipped. 0 is not valid, and
+    //! the smallest int has no positive value.
+    static inline bool
+    isFaceAddr(FOAM_INT32 addr)
+    {
+        return (0 != addr) && (std::numeric_limits<FOAM_INT32>::min() != addr);
+    }
+
+
+    //! \return The 0 based global face index of face address addr.
+    static inline FOAM_UINT32
+    faceIndex(FOAM_INT32 addr)
+    {
+        return static_cast<FOAM_UINT32>((addr < 0) ? -addr : addr) - 1;
+    }
+
+
+    //! Sets an unset cell index. A face side claimed by two ranks is an error.
+    static inline bool
+    setOnce(FOAM_UINT32 &dest, FOAM_UINT32 val)
+    {
+        const bool ret = (FOAM_UINT32_MAX == dest);
+        if (ret) {
+            dest = val;
+        }
+        return ret;
+    }
+
+
+    CollatedFile &
+    file(FileId fileId)
+    {
+        switch (fileId) {
+        case Points:    return pointsFile_;
+        case Faces:     return facesFile_;
+        case Owner:     return ownerFile_;
+        case Neighbour: return neighborFile_;
+        case PointAddr: return pointAddrFile_;
+        case FaceAddr:  return faceAddrFile_;
+        default:        break;
+        }
+        return cellAddrFile_;
+    }
+
+private:
+    CollatedPolyMesh(const CollatedPolyMesh&);
+    const CollatedPolyMesh& operator=(const CollatedPolyMesh&);
+
+private:
+    CollatedFile    pointsFile_;
+    CollatedFile    facesFile_;
+    CollatedFile    ownerFile_;
+    CollatedFile    neighborFile_;
+    CollatedFile    pointAddrFile_;
+    CollatedFile    faceAddrFile_;
+    CollatedFile    cellAddrFile_;
+    RankDataArray1  ranks_;         //!< The parsed per rank data
+    DoubleArray1    xyz_;           //!< The merged points
+    FaceArray1      faces_;         //!< The merged faces
+    UInt32Array1    owner_;         //!< The merged face owner cells
+    UInt32Array1    neighbor_;      //!< The merged face neighbor cells
+    FOAM_UINT32     numInternal_;   //!< The number of merged interior faces
+};
+
+#endif // COLLATEDPOLYMESH_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
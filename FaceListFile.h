@@ -16,11 +16,11 @@
 #ifndef FACELISTFILE_H
 #define FACELISTFILE_H
 
+#include "FoamBuffer.h"
 #include "FoamFile.h"
+#include "FoamTypes.h"
 
-#include "apiGRDPUtils.h"
-#include "apiGridModel.h"
-#include "apiPWP.h"
+#include <algorithm>
 
 
 //---------------------------------------------------------------------------
@@ -28,6 +28,12 @@
 //---------------------------------------------------------------------------
 
 /*! A class for reading OpenFOAM faceList files.
+
+    Most meshes are all quad faces (hex) or all tri faces (tet). For those,
+    readFaces() decodes batches with a fixed-arity kernel that scans the
+    buffered chars in place. A face the kernel cannot decode, such as one
+    that crosses the end of the buffer or has another vertex count, is read
+    by readNextFace(). So, a mixed mesh is still read correctly.
 */
 class FaceListFile : public FoamFile {
 public:
@@ -44,41 +50,160 @@ public:
 
 
     //! \return The number of faces in this file.
-    inline PWP_UINT32   getNumFaces() const {
+    inline FOAM_UINT32  getNumFaces() const {
                             return numFaces_; }
 
 
+    //! Reads up to numSample faces and rewinds to the first face. Must be
+    //! called before any face is read.
+    //! \return The vertex count shared by the sampled faces. 0 if they
+    //! differ or could not be read.
+    FOAM_UINT32
+    sampleVertCnt(FOAM_UINT32 numSample = 1024)
+    {
+        const FOAM_UINT32 cnt = std::min(numSample, numFaces_);
+        FOAM_UINT32 ret = 0;
+        FoamFace data;
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            if (!readNextFace(data) || ((0 != ii) && (ret != data.vertCnt))) {
+                ret = 0;
+                break;
+            }
+            ret = data.vertCnt;
+        }
+        return rewindToBeginData() ? ret : 0;
+    }
+
+
+    /*! Reads the next cnt faces into faces.
+
+        If vertCnt is 3 or 4, the faces with vertCnt vertices are decoded by
+        the fixed-arity kernel. Any other value reads every face with
+        readNextFace().
+
+        \return false if any face could not be read. uniform is set to true
+        if every face has vertCnt vertices.
+    */
+    bool
+    readFaces(FoamFace *faces, FOAM_UINT32 cnt, FOAM_UINT32 vertCnt,
+        bool &uniform)
+    {
+        bool ret = true;
+        uniform = true;
+        FOAM_UINT32 ii = 0;
+        while ((ii < cnt) && ret) {
+            const char *pos = bufferPos();
+            if (4 == vertCnt) {
+                ii += decodeFixed<4>(pos, bufferEnd(), faces + ii, cnt - ii);
+            }
+            else if (3 == vertCnt) {
+                ii += decodeFixed<3>(pos, bufferEnd(), faces + ii, cnt - ii);
+            }
+            consumeTo(pos);
+            if (ii < cnt) {
+                // The kernel stopped at a face it cannot decode
+                ret = readNextFace(faces[ii]);
+                uniform = uniform && (vertCnt == faces[ii].vertCnt);
+                ++ii;
+            }
+        }
+        return ret;
+    }
+
+
     //! Reads the next face from the file into data.
     //! \return true if data contains a valid face. false if face data could not
     //! be read or if an unsupported face type is detected.
-    bool readNextFace(PWGM_ASSEMBLER_DATA &data)
+    bool readNextFace(FoamFace &data)
     {
-        bool ret = readInt(data.vertCnt) && wspaceSkipToChar('(');
+        return foamReadFace(*this, data);
+    }
+
+
+private:
+    //! \return true if c is white space in the C locale.
+    inline static bool
+    isSpace(unsigned char c)
+    {
+        return (' ' == c) || (static_cast<unsigned int>(c - '\t') < 5);
+    }
+
+
+    //! Decodes the unsigned int at pos. Leading white space is skipped.
+    //! \return false if there is no int, it overflows or it ends the range.
+    inline static bool
+    decodeUInt(const char *&pos, const char *end, FOAM_UINT32 &val)
+    {
+        const char *p = pos;
+        while ((p < end) && isSpace(static_cast<unsigned char>(*p))) {
+            ++p;
+        }
+        unsigned int digit;
+        if ((p == end) ||
+                (10 <= (digit = static_cast<unsigned char>(*p) - '0'))) {
+            return false;
+        }
+        FOAM_UINT64 v = 0;
+        do {
+            v = (v * 10) + digit;
+            ++p;
+        } while ((p < end) &&
+            ((digit = static_cast<unsigned char>(*p) - '0') < 10) &&
+            (v <= FOAM_UINT32_MAX));
+        // The int may continue past end
+        const bool ret = (p < end) && (v <= FOAM_UINT32_MAX);
         if (ret) {
-            switch (data.vertCnt) {
-            case 4:
-                // each face has form: "4(3 9 10 0)"
-                ret = readInt(data.index[0]) && readInt(data.index[1]) &&
-                    readInt(data.index[2]) && readInt(data.index[3]) &&
-                    wspaceSkipToChar(')');
-                break;
-            case 3:
-                // each face has form: "3(3 9 10)"
-                ret = readInt(data.index[0]) && readInt(data.index[1]) &&
-                    readInt(data.index[2]) && wspaceSkipToChar(')');
-                break;
-            default:
-                // Unsupported face type!
-                // TODO: support other face types
-                ret = false;
+            val = static_cast<FOAM_UINT32>(v);
+            pos = p;
+        }
+        return ret;
+    }
+
+
+    //! Skips the white space at pos and the char ch.
+    //! \return false if the next non white space char is not ch.
+    inline static bool
+    decodeChar(const char *&pos, const char *end, char ch)
+    {
+        const char *p = pos;
+        while ((p < end) && isSpace(static_cast<unsigned char>(*p))) {
+            ++p;
+        }
+        const bool ret = (p < end) && (ch == *p);
+        if (ret) {
+            pos = p + 1;
+        }
+        return ret;
+    }
+
+
+    //! Decodes up to cnt faces of the form "VertCnt(i0 i1 ...)" from the
+    //! chars in [pos, end). Stops at the first face that has another vertex
+    //! count or is not complete. pos is left after the last decoded face.
+    //! \return The number of decoded faces.
+    template<FOAM_UINT32 VertCnt>
+    static FOAM_UINT32
+    decodeFixed(const char *&pos, const char *end, FoamFace *faces,
+        FOAM_UINT32 cnt)
+    {
+        FOAM_UINT32 ii = 0;
+        for (; ii < cnt; ++ii) {
+            const char *p = pos;
+            FoamFace &face = faces[ii];
+            bool ok = decodeUInt(p, end, face.vertCnt) &&
+                (VertCnt == face.vertCnt) && decodeChar(p, end, '(');
+            for (FOAM_UINT32 jj = 0; jj < VertCnt; ++jj) {
+                ok = ok && decodeUInt(p, end, face.index[jj]);
+            }
+            if (!ok || !decodeChar(p, end, ')')) {
                 break;
             }
+            pos = p;
         }
-        return ret;
+        return ii;
     }
 
 
-private:
     //! Validate header values, capture total face count, leave file pos on
     //! first char after (, and re-mark data begin position.
     virtual bool
@@ -101,7 +226,7 @@ private:
 
 
 private:
-    PWP_UINT32  numFaces_;  //!< The number of faces in the file
+    FOAM_UINT32  numFaces_;  //!< The number of faces in the file
 };
 
 #endif // FACELISTFILE_H
@@ -0,0 +1,628 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMARCHIVE_H
+#define FOAMARCHIVE_H
+
+#include "FoamBuffer.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(FOAM_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The polyMesh files inside a tar archive.
+
+    The archive is indexed once when it is opened. Only the members in a
+    polyMesh directory are indexed. Both ustar and GNU tars are supported,
+    including GNU and pax long names and pax sizes.
+
+    An uncompressed tar is mapped and each member is found at its offset in
+    the mapping. No member data is copied.
+
+    A gzip compressed tar is inflated in a single pass. Only the polyMesh
+    members are kept and all others are discarded as they stream by. This
+    needs zlib and FOAM_HAVE_ZLIB must be defined. A gzip stream cannot be
+    split, so it is inflated on the calling thread. The current FoamTaskPool
+    poll is called for each chunk so an abort stops it promptly.
+
+    An archive may hold several polyMesh directories. If none is given to
+    open(), the first "constant/polyMesh" directory in name order is used.
+*/
+class FoamArchive {
+    enum {
+        BlockSize = 512     //!< The tar header and data alignment
+    };
+
+    //! The location of a member's data
+    struct Member {
+        const char *    data;   //!< The first byte of the member
+        size_t          size;   //!< The member size in bytes
+    };
+
+    typedef std::map<std::string, Member>               MemberMap;
+    typedef std::map<std::string, std::vector<char> >   DataMap;
+
+public:
+
+    FoamArchive() :
+        file_(),
+        members_(),
+        inflated_(),
+        meshDir_(),
+        findDir_(false)
+    {
+    }
+
+    ~FoamArchive()
+    {
+    }
+
+
+    /*! Indexes the polyMesh members of the tar in fileName.
+        meshDir is the archive directory holding the polyMesh files, such as
+        "case/constant/polyMesh". If it is empty, it is found automatically.
+        \return false if the archive is not a valid tar or has no faces.
+    */
+    bool
+    open(const char *fileName, const char *meshDir = "")
+    {
+        close();
+        meshDir_ = normalize(meshDir);
+        if (!meshDir_.empty() && ('/' != meshDir_[meshDir_.size() - 1])) {
+            meshDir_ += '/';
+        }
+        findDir_ = meshDir_.empty();
+        bool ret = file_.open(fileName) && (2 <= file_.size());
+        if (ret && ('\x1f' == file_.begin()[0]) &&
+                ('\x8b' == file_.begin()[1])) {
+#if defined(FOAM_HAVE_ZLIB)
+            GzipSource src(file_.begin(), file_.end(), inflated_);
+            ret = src.isOk() && index(src);
+            // The compressed data is no longer needed
+            file_.close();
+#else
+            ret = false;
+#endif
+        }
+        else if (ret) {
+            MappedSource src(file_.begin(), file_.end());
+            ret = index(src);
+        }
+        ret = ret && findMeshDir();
+        if (!ret) {
+            close();
+        }
+        return ret;
+    }
+
+
+    //! Releases the archive.
+    void
+    close()
+    {
+        file_.close();
+        members_.clear();
+        inflated_.clear();
+        meshDir_.clear();
+        findDir_ = false;
+    }
+
+
+    //! \return true if the archive is open.
+    inline bool     isOpen() const {
+                        return !members_.empty(); }
+
+    //! \return true if the archive was gzip compressed.
+    inline bool     isCompressed() const {
+                        return !inflated_.empty(); }
+
+    //! \return The archive directory holding the polyMesh files.
+    inline const std::string &
+                    getMeshDir() const {
+                        return meshDir_; }
+
+
+    //! Finds the named file in the mesh directory.
+    //! \return false if the archive has no such file.
+    bool
+    find(const std::string &fileName, const char *&data, size_t &size) const
+    {
+        MemberMap::const_iterator it = members_.find(meshDir_ + fileName);
+        const bool ret = (members_.end() != it);
+        if (ret) {
+            data = it->second.data;
+            size = it->second.size;
+        }
+        return ret;
+    }
+
+private:
+
+    //! Reads the members of an uncompressed tar in place.
+    class MappedSource {
+    public:
+        MappedSource(const char *begin, const char *end) :
+            pos_(begin),
+            end_(end)
+        {
+        }
+
+        bool
+        read(char *dst, size_t cnt)
+        {
+            const bool ret = skip(cnt);
+            if (ret) {
+                std::memcpy(dst, pos_ - cnt, cnt);
+            }
+            return ret;
+        }
+
+        //! \return true if all bytes were read.
+        inline bool atEnd() const {
+                        return pos_ == end_; }
+
+        //! Any bytes after the end blocks are ignored.
+        inline bool finish() {
+                        return true; }
+
+        bool
+        skip(FOAM_UINT64 cnt)
+        {
+            const bool ret = (cnt <= static_cast<FOAM_UINT64>(end_ - pos_));
+            if (ret) {
+                pos_ += cnt;
+            }
+            return ret;
+        }
+
+        //! Returns the next cnt bytes in place.
+        bool
+        keep(const std::string &, FOAM_UINT64 cnt, const char *&data)
+        {
+            data = pos_;
+            return skip(cnt);
+        }
+
+    private:
+        const char *    pos_;   //!< The next byte to read
+        const char *    end_;   //!< One past the last byte
+    };
+
+
+#if defined(FOAM_HAVE_ZLIB)
+    //! Inflates the members of a gzip compressed tar as they are read.
+    class GzipSource {
+        enum {
+            ChunkSize = 1024 * 1024 //!< The max input and skip chunk size
+        };
+
+    public:
+        GzipSource(const char *begin, const char *end, DataMap &inflated) :
+            pos_(begin),
+            end_(end),
+            inflated_(inflated),
+            scratch_(ChunkSize),
+            ok_(false),
+            ended_(false)
+        {
+            std::memset(&strm_, 0, sizeof(strm_));
+            // 32 enables gzip header detection
+            ok_ = (Z_OK == inflateInit2(&strm_, 15 + 32));
+        }
+
+        ~GzipSource()
+        {
+            if (ok_) {
+                inflateEnd(&strm_);
+            }
+        }
+
+        inline bool isOk() const {
+                        return ok_; }
+
+        //! \return true if the last gzip stream ended and all its bytes
+        //! were read.
+        inline bool atEnd() const {
+                        return ended_; }
+
+        bool
+        read(char *dst, size_t cnt)
+        {
+            bool ret = ok_;
+            strm_.next_out = reinterpret_cast<Bytef*>(dst);
+            strm_.avail_out = static_cast<uInt>(cnt);
+            while (ret && (0 < strm_.avail_out)) {
+                if ((0 == strm_.avail_in) && (pos_ < end_)) {
+                    if (!FoamTaskPool::poll()) {
+                        // aborted
+                        return false;
+                    }
+                    const size_t num = chunk(end_ - pos_);
+                    strm_.next_in = reinterpret_cast<Bytef*>(
+                        const_cast<char*>(pos_));
+                    strm_.avail_in = static_cast<uInt>(num);
+                    pos_ += num;
+                }
+                const int err = inflate(&strm_, Z_NO_FLUSH);
+                if (Z_STREAM_END == err) {
+                    // A gzip file may hold several concatenated streams. A
+                    // read filled by the end of the last one is complete.
+                    ended_ = (0 == strm_.avail_in) && (pos_ == end_);
+                    ret = ended_ ? (0 == strm_.avail_out) :
+                        (Z_OK == inflateReset(&strm_));
+                }
+                else {
+                    ret = (Z_OK == err);
+                }
+            }
+            return ret;
+        }
+
+        //! Inflates and discards the rest of the data after the end blocks,
+        //! so a truncated or corrupt stream is still found.
+        bool
+        finish()
+        {
+            bool ret = true;
+            while (ret && !ended_) {
+                ret = read(&scratch_[0], scratch_.size()) || ended_;
+            }
+            return ret;
+        }
+
+        bool
+        skip(FOAM_UINT64 cnt)
+        {
+            bool ret = true;
+            while (ret && (0 < cnt)) {
+                const size_t num = chunk(cnt);
+                ret = read(&scratch_[0], num);
+                cnt -= num;
+            }
+            return ret;
+        }
+
+        //! Inflates the next cnt bytes into a buffer owned by the archive.
+        bool
+        keep(const std::string &name, FOAM_UINT64 cnt, const char *&data)
+        {
+            std::vector<char> &buf = inflated_[name];
+            bool ret = (cnt < static_cast<FOAM_UINT64>(size_t(-1)));
+            if (ret) {
+                buf.resize(static_cast<size_t>(cnt));
+                data = buf.empty() ? 0 : &buf[0];
+            }
+            for (size_t done = 0; ret && (done < buf.size());
+                    done += ChunkSize) {
+                const size_t num = chunk(buf.size() - done);
+                ret = read(&buf[done], num);
+            }
+            return ret;
+        }
+
+    private:
+        //! \return The smaller of cnt and ChunkSize.
+        static size_t
+        chunk(FOAM_UINT64 cnt)
+        {
+            return (cnt < FOAM_UINT64(ChunkSize)) ? static_cast<size_t>(cnt) :
+                static_cast<size_t>(ChunkSize);
+        }
+
+    private:
+        GzipSource(const GzipSource&);
+        const GzipSource& operator=(const GzipSource&);
+
+    private:
+        z_stream            strm_;      //!< The inflate state
+        const char *        pos_;       //!< The next compressed byte
+        const char *        end_;       //!< One past the last compressed byte
+        DataMap &           inflated_;  //!< The kept member data
+        std::vector<char>   scratch_;   //!< The skipped data
+        bool                ok_;        //!< true if strm_ is initialized
+        bool                ended_;     //!< true if the last stream ended
+    };
+#endif // FOAM_HAVE_ZLIB
+
+
+    //! Walks the tar headers and indexes the polyMesh members. The archive
+    //! must end with its two zero blocks or right after a member. Any other
+    //! read failure is a truncated or corrupt archive.
+    template<typename Source>
+    bool
+    index(Source &src)
+    {
+        char hdr[BlockSize];
+        std::string longName;
+        FOAM_UINT64 paxSize = FOAM_UINT64(-1);
+        bool ret = true;
+        while (ret && !src.atEnd()) {
+            ret = src.read(hdr, BlockSize);
+            if (ret && isZeroBlock(hdr)) {
+                // The second zero block may be missing. Any padding after
+                // it is ignored.
+                ret = src.atEnd() || (src.read(hdr, BlockSize) &&
+                    isZeroBlock(hdr));
+                break;
+            }
+            FOAM_UINT64 size = 0;
+            ret = ret && checksumOk(hdr) && readSize(hdr, size);
+            if (!ret) {
+                break;
+            }
+            size = (FOAM_UINT64(-1) == paxSize) ? size : paxSize;
+            const FOAM_UINT64 pad = (BlockSize - (size % BlockSize)) %
+                BlockSize;
+            const char type = hdr[156];
+            if (('L' == type) || ('x' == type)) {
+                // A GNU long name or pax extended header for the next member
+                std::vector<char> ext(static_cast<size_t>(size) + 1, '\0');
+                ret = (size < (1 << 20)) && src.read(&ext[0],
+                    static_cast<size_t>(size)) && src.skip(pad);
+                if (ret && ('L' == type)) {
+                    longName = &ext[0];
+                }
+                else if (ret) {
+                    readPax(ext, longName, paxSize);
+                }
+                continue;
+            }
+            std::string name = longName.empty() ? headerName(hdr) : longName;
+            name = normalize(name.c_str());
+            longName.clear();
+            paxSize = FOAM_UINT64(-1);
+            const char *data = 0;
+            if ((('0' == type) || ('\0' == type) || ('7' == type)) &&
+                    isWanted(name)) {
+                ret = src.keep(name, size, data) && src.skip(pad);
+                const Member member = { data, static_cast<size_t>(size) };
+                if (ret) {
+                    members_[name] = member;
+                }
+            }
+            else {
+                ret = src.skip(size + pad);
+            }
+        }
+        return ret && src.finish();
+    }
+
+
+    //! \return true if all bytes of the block are zero.
+    static bool
+    isZeroBlock(const char *hdr)
+    {
+        return (hdr + BlockSize) == std::find_if(hdr, hdr + BlockSize,
+            [](char c) { return '\0' != c; });
+    }
+
+
+    //! \return true if the header checksum is valid.
+    static bool
+    checksumOk(const char *hdr)
+    {
+        // The checksum is computed with its own field set to spaces
+        FOAM_UINT64 sum = 0;
+        for (int ii = 0; ii < BlockSize; ++ii) {
+            sum += ((148 <= ii) && (ii < 156)) ? ' ' :
+                static_cast<unsigned char>(hdr[ii]);
+        }
+        FOAM_UINT64 val = 0;
+        return readOctal(hdr + 148, 8, val) && (val == sum);
+    }
+
+
+    //! Reads the member size. Sizes over 8GB are stored in base 256.
+    static bool
+    readSize(const char *hdr, FOAM_UINT64 &size)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char*>(hdr);
+        bool ret = true;
+        if (0x80 & p[124]) {
+            size = 0;
+            for (int ii = 125; ii < 136; ++ii) {
+                size = (size << 8) | p[ii];
+            }
+        }
+        else {
+            ret = readOctal(hdr + 124, 12, size);
+        }
+        return ret;
+    }
+
+
+    //! Reads a space or NUL terminated octal field.
+    static bool
+    readOctal(const char *field, int len, FOAM_UINT64 &val)
+    {
+        int ii = 0;
+        while ((ii < len) && (' ' == field[ii])) {
+            ++ii;
+        }
+        val = 0;
+        const int beg = ii;
+        for (; (ii < len) && ('0' <= field[ii]) && (field[ii] <= '7'); ++ii) {
+            val = (val << 3) | static_cast<FOAM_UINT64>(field[ii] - '0');
+        }
+        return (beg < ii) &&
+            ((ii == len) || (' ' == field[ii]) || ('\0' == field[ii]));
+    }
+
+
+    //! \return The member name from the ustar prefix and name fields.
+    static std::string
+    headerName(const char *hdr)
+    {
+        const std::string name(hdr, std::find(hdr, hdr + 100, '\0'));
+        std::string ret;
+        // Only a POSIX ustar header has a prefix. An old GNU header has the
+        // magic "ustar  " and other fields in its place.
+        if (0 == std::memcmp(hdr + 257, "ustar", 6)) {
+            ret.assign(hdr + 345, std::find(hdr + 345, hdr + 500, '\0'));
+        }
+        return ret.empty() ? name : (ret + '/' + name);
+    }
+
+
+    //! Reads the path and size records of a pax extended header.
+    //! Each record is "<len> <key>=<value>\n".
+    static void
+    readPax(const std::vector<char> &ext, std::string &path,
+        FOAM_UINT64 &size)
+    {
+        const char *p = &ext[0];
+        const char *end = p + ext.size() - 1;
+        while (p < end) {
+            char *val;
+            const unsigned long len = std::strtoul(p, &val, 10);
+            if ((0 == len) || (len > static_cast<unsigned long>(end - p))) {
+                break;
+            }
+            const std::string rec(static_cast<const char*>(val) + 1,
+                p + len - 1);
+            if (0 == rec.compare(0, 5, "path=")) {
+                path = rec.substr(5);
+            }
+            else if (0 == rec.compare(0, 5, "size=")) {
+                size = std::strtoull(rec.c_str() + 5, 0, 10);
+            }
+            p += len;
+        }
+    }
+
+
+    //! \return name without any leading "./" or "/".
+    static std::string
+    normalize(const char *name)
+    {
+        while (('.' == name[0]) && ('/' == name[1])) {
+            name += 2;
+        }
+        while ('/' == name[0]) {
+            ++name;
+        }
+        return name;
+    }
+
+
+    /*! \return true if name is a file of the mesh directory that may be
+        read. If no mesh directory was given, the first polyMesh directory
+        is used until a constant/polyMesh directory replaces it, and the
+        members of the replaced one are dropped. The meshes of decomposed
+        cases are never used. So a compressed archive only inflates the
+        files of one mesh, and at most two if a time directory mesh comes
+        before the constant one.
+    */
+    bool
+    isWanted(const std::string &name)
+    {
+        static const char * const Files[] = { "faces", "owner", "neighbour",
+            "points", "boundary", "cellZones", "faceZones", "pointZones", 0 };
+        const std::string::size_type slash = name.rfind('/');
+        const std::string dir = (std::string::npos == slash) ? "" :
+            name.substr(0, slash + 1);
+        const std::string base = name.substr(dir.size());
+        bool ret = false;
+        for (int ii = 0; (0 != Files[ii]) && !ret; ++ii) {
+            ret = (base == Files[ii]);
+        }
+        if (ret && findDir_ && (meshDir_ != dir) &&
+                endsWithDir(dir, "polyMesh/") && !isProcessorDir(dir) &&
+                (meshDir_.empty() || (endsWithDir(dir, "constant/polyMesh/") &&
+                    !endsWithDir(meshDir_, "constant/polyMesh/")))) {
+            // Only the members of the mesh directory are kept
+            members_.clear();
+            inflated_.clear();
+            meshDir_ = dir;
+        }
+        return ret && !meshDir_.empty() && (meshDir_ == dir);
+    }
+
+
+    //! \return true if dir is tail or ends with "/" + tail.
+    static bool
+    endsWithDir(const std::string &dir, const std::string &tail)
+    {
+        return (dir == tail) || ((tail.size() < dir.size()) &&
+            (0 == dir.compare(dir.size() - tail.size() - 1,
+                std::string::npos, "/" + tail)));
+    }
+
+
+    //! \return true if a directory of dir is a processor directory of a
+    //! decomposed case, such as "processor0/" or "processors4/".
+    static bool
+    isProcessorDir(const std::string &dir)
+    {
+        const std::string Processor("processor");
+        std::string::size_type pos = 0;
+        bool ret = false;
+        while (!ret && (pos < dir.size())) {
+            ret = (0 == dir.compare(pos, Processor.size(), Processor));
+            pos = dir.find('/', pos);
+            pos = (std::string::npos == pos) ? pos : (pos + 1);
+        }
+        return ret;
+    }
+
+
+    //! \return false if the mesh directory has no faces file.
+    bool
+    findMeshDir()
+    {
+        const char *data;
+        size_t size;
+        return find("faces", data, size);
+    }
+
+private:
+    FoamArchive(const FoamArchive&);
+    const FoamArchive& operator=(const FoamArchive&);
+
+private:
+    FoamMappedFile      file_;      //!< The mapped archive
+    MemberMap           members_;   //!< The indexed polyMesh members
+    DataMap             inflated_;  //!< The member data of a compressed tar
+    std::string         meshDir_;   //!< The mesh directory with a trailing /
+    bool                findDir_;   //!< Whether meshDir_ is found by index()
+};
+
+#endif // FOAMARCHIVE_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,331 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMARENA_H
+#define FOAMARENA_H
+
+#include "FoamTypes.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#endif
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! One address range reserved up front for all import staging buffers.
+
+    The range is sized from the header counts before any data is read and is
+    reserved once. Pages are only backed by memory when they are first
+    touched, so reserving more than is used costs address space only. On
+    Linux the range may use transparent huge pages to cut page faults and TLB
+    misses on very large imports.
+
+    Buffers are handed out in order and are never freed individually. The
+    whole range is released with the arena. If the range is full or was never
+    reserved, FoamArenaAllocator falls back to the heap and the arena counts
+    those bytes, so the report shows how well the reservation was sized.
+
+    allocate() is not thread safe. Buffers should be allocated by the thread
+    that runs the reader. They may then be filled by any thread.
+*/
+class FoamArena {
+public:
+    enum {
+        Align = 64,                 //!< The alignment of every buffer
+        HugePageSize = 2 << 20      //!< The transparent huge page size
+    };
+
+    FoamArena() :
+        map_(0),
+        mapSize_(0),
+        base_(0),
+        reserved_(0),
+        used_(0),
+        heapBytes_(0),
+        hugePages_(false)
+    {
+    }
+
+    ~FoamArena()
+    {
+        release();
+    }
+
+
+    //! \return The arena bytes needed for cnt values of type T.
+    template<typename T>
+    static FOAM_UINT64
+    bytesFor(FOAM_UINT64 cnt)
+    {
+        return (cnt * sizeof(T) + Align - 1) & ~FOAM_UINT64(Align - 1);
+    }
+
+
+    /*! Reserves numBytes of address space. If hugePages is true and the
+        platform supports it, the range is marked for transparent huge pages.
+        \return false if the arena is already reserved or the reservation
+        failed. The allocator then uses the heap.
+    */
+    bool
+    reserve(FOAM_UINT64 numBytes, bool hugePages)
+    {
+        if ((0 != base_) || (0 == numBytes) ||
+                (numBytes > static_cast<FOAM_UINT64>(size_t(-1) / 2))) {
+            return false;
+        }
+        reserved_ = static_cast<size_t>(numBytes);
+#if defined(_WIN32)
+        // Pages are committed as they are handed out
+        (void)hugePages;
+        map_ = VirtualAlloc(0, reserved_, MEM_RESERVE, PAGE_READWRITE);
+        mapSize_ = reserved_;
+        base_ = static_cast<char*>(map_);
+#else
+        // Huge pages must start on a huge page boundary
+        const size_t pad = hugePages ? size_t(HugePageSize) : 0;
+        if (hugePages) {
+            reserved_ = (reserved_ + pad - 1) & ~(pad - 1);
+        }
+        mapSize_ = reserved_ + pad;
+        void *p = mmap(0, mapSize_, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        map_ = (MAP_FAILED == p) ? 0 : p;
+        if (0 != map_) {
+            const size_t addr = reinterpret_cast<size_t>(map_);
+            base_ = static_cast<char*>(map_) +
+                (pad ? ((pad - (addr & (pad - 1))) & (pad - 1)) : 0);
+        }
+#   if defined(MADV_HUGEPAGE)
+        hugePages_ = hugePages && (0 != base_) &&
+            (0 == madvise(base_, reserved_, MADV_HUGEPAGE));
+#   endif
+#endif
+        if (0 == base_) {
+            mapSize_ = 0;
+            reserved_ = 0;
+        }
+        return 0 != base_;
+    }
+
+
+    //! Releases the reserved range. All buffers in it become invalid.
+    void
+    release()
+    {
+        if (0 != map_) {
+#if defined(_WIN32)
+            VirtualFree(map_, 0, MEM_RELEASE);
+#else
+            munmap(map_, mapSize_);
+#endif
+        }
+        map_ = 0;
+        mapSize_ = 0;
+        base_ = 0;
+        reserved_ = 0;
+        used_ = 0;
+        hugePages_ = false;
+    }
+
+
+    //! \return numBytes from the reserved range or 0 if it does not fit.
+    void *
+    allocate(size_t numBytes)
+    {
+        const size_t size = static_cast<size_t>(bytesFor<char>(numBytes));
+        if ((0 == base_) || (size > (reserved_ - used_))) {
+            return 0;
+        }
+        char *p = base_ + used_;
+#if defined(_WIN32)
+        if ((0 != size) && (0 == VirtualAlloc(p, size, MEM_COMMIT,
+                PAGE_READWRITE))) {
+            return 0;
+        }
+#endif
+        used_ += size;
+        return p;
+    }
+
+
+    //! \return true if p is in the reserved range.
+    inline bool     owns(const void *p) const {
+                        return (0 != base_) && (base_ <= p) &&
+                            (p < base_ + reserved_); }
+
+    //! Counts numBytes that did not fit in the arena.
+    inline void     addHeapBytes(size_t numBytes) {
+                        heapBytes_ += numBytes; }
+
+    //! \return The reserved bytes.
+    inline size_t   getReserved() const {
+                        return reserved_; }
+
+    //! \return The bytes handed out. Since nothing is freed, this is also
+    //! the peak.
+    inline size_t   getUsed() const {
+                        return used_; }
+
+    //! \return The bytes that fell back to the heap.
+    inline FOAM_UINT64
+                    getHeapBytes() const {
+                        return heapBytes_; }
+
+    //! \return true if the range uses transparent huge pages.
+    inline bool     hasHugePages() const {
+                        return hugePages_; }
+
+
+    //! Writes the reserved, used and heap byte counts to fileName.
+    bool
+    writeReport(const char *fileName) const
+    {
+        FILE *fp = std::fopen(fileName, "w");
+        bool ret = (0 != fp);
+        if (ret) {
+            const double MB = 1024.0 * 1024.0;
+            std::fprintf(fp, "OpenFOAM import staging memory\n");
+            std::fprintf(fp, "reserved            %.1f MB\n", reserved_ / MB);
+            std::fprintf(fp, "used (peak)         %.1f MB (%.1f%%)\n",
+                used_ / MB, reserved_ ? (100.0 * used_ / reserved_) : 0.0);
+            std::fprintf(fp, "heap fallback       %.1f MB\n",
+                static_cast<double>(heapBytes_) / MB);
+            std::fprintf(fp, "huge pages          %s\n",
+                hugePages_ ? "yes" : "no");
+            ret = (0 == std::ferror(fp));
+            ret = (0 == std::fclose(fp)) && ret;
+        }
+        return ret;
+    }
+
+private:
+    FoamArena(const FoamArena&);
+    const FoamArena& operator=(const FoamArena&);
+
+private:
+    void *          map_;       //!< The start of the mapping
+    size_t          mapSize_;   //!< The mapping size in bytes
+    char *          base_;      //!< The first byte of the aligned range
+    size_t          reserved_;  //!< The usable range size in bytes
+    size_t          used_;      //!< The bytes handed out
+    FOAM_UINT64     heapBytes_; //!< The bytes that fell back to the heap
+    bool            hugePages_; //!< true if madvise(MADV_HUGEPAGE) succeeded
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A std::vector allocator that takes its memory from a FoamArena.
+
+    A default constructed allocator, or one whose arena is full, uses the
+    heap. Memory from the arena is only released with the arena, so a vector
+    should be sized once with resize() or assign() instead of grown.
+*/
+template<typename T>
+class FoamArenaAllocator {
+public:
+    typedef T   value_type;
+
+    FoamArenaAllocator(FoamArena *arena = 0) :
+        arena_(arena)
+    {
+    }
+
+    template<typename U>
+    FoamArenaAllocator(const FoamArenaAllocator<U> &other) :
+        arena_(other.getArena())
+    {
+    }
+
+
+    T *
+    allocate(size_t cnt)
+    {
+        const size_t numBytes = cnt * sizeof(T);
+        void *p = (0 == arena_) ? 0 : arena_->allocate(numBytes);
+        if (0 == p) {
+            p = ::operator new(numBytes);
+            if (0 != arena_) {
+                arena_->addHeapBytes(numBytes);
+            }
+        }
+        return static_cast<T*>(p);
+    }
+
+
+    void
+    deallocate(T *p, size_t)
+    {
+        if ((0 == arena_) || !arena_->owns(p)) {
+            ::operator delete(p);
+        }
+    }
+
+
+    //! \return The arena or 0 if the heap is used.
+    inline FoamArena *  getArena() const {
+                            return arena_; }
+
+private:
+    FoamArena * arena_;     //!< The arena to allocate from or 0
+};
+
+
+template<typename T, typename U>
+inline bool
+operator==(const FoamArenaAllocator<T> &a, const FoamArenaAllocator<U> &b)
+{
+    return a.getArena() == b.getArena();
+}
+
+
+template<typename T, typename U>
+inline bool
+operator!=(const FoamArenaAllocator<T> &a, const FoamArenaAllocator<U> &b)
+{
+    return a.getArena() != b.getArena();
+}
+
+
+typedef std::vector<FOAM_UINT32, FoamArenaAllocator<FOAM_UINT32> >
+    FoamLabelArray1;
+typedef std::vector<FoamFace, FoamArenaAllocator<FoamFace> >
+    FoamFaceArray1;
+
+#endif // FOAMARENA_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
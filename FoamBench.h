@@ -0,0 +1,606 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMBENCH_H
+#define FOAMBENCH_H
+
+#include "CellFaceCsr.h"
+#include "FaceListFile.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "LabelListFile.h"
+#include "PolyMeshHandler.h"
+#include "VectorFieldFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#   define FOAM_BENCH_RDTSC() __rdtsc()
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define FOAM_BENCH_RDTSC() __rdtsc()
+#endif
+
+
+//! The timing of one parsing primitive
+struct FoamBenchResult {
+    std::string     name;       //!< The primitive name
+    FOAM_UINT64     records;    //!< The records parsed per run
+    FOAM_UINT64     bytes;      //!< The corpus size in bytes
+    double          seconds;    //!< The fastest run time
+    FOAM_UINT64     cycles;     //!< The TSC cycles of the fastest run or 0
+
+    //! \return The time per record in ns.
+    double          nsPerRecord() const {
+                        return 1.0e9 * seconds / static_cast<double>(records); }
+
+    //! \return The bytes parsed per cycle. 0 if cycles are not available.
+    double          bytesPerCycle() const {
+                        return (0 == cycles) ? 0.0 :
+                            static_cast<double>(bytes) / cycles; }
+};
+
+typedef std::vector<FoamBenchResult>    FoamBenchResultArray1;
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Microbenchmarks of the FoamFile parsing primitives.
+
+    Each primitive parses a generated corpus of a controlled number of
+    records. The corpus is generated in memory once and then parsed numReps
+    times with FoamFile::open(data, size). Only the parsing is timed. There
+    is no file I/O. The fastest run is reported.
+
+    The primitives are:
+      * comments - FoamFile::wspaceCommentsSkip() over dense // and
+        C style comments
+      * header   - FoamFile::readHeader() of a header with many entries
+      * labels   - LabelListFile::readNextLabel()
+      * faces    - FaceListFile::readNextFace() of a 1:3 tri/quad mix
+      * quads    - FaceListFile::readNextFace() of all quad faces
+      * quads-fix - FaceListFile::readFaces() of all quad faces using the
+        fixed-arity kernel
+      * tris     - FaceListFile::readNextFace() of all tri faces
+      * tris-fix - FaceListFile::readFaces() of all tri faces using the
+        fixed-arity kernel
+      * points   - VectorFieldFile::read()
+      * adjacency - CellFaceCsr::build() of a hex block on all hardware
+        threads. Each record is a face.
+      * adjacency-1 - the same on one thread
+
+    Results can be saved as a baseline file and later runs compared against
+    it. Any primitive more than a threshold slower than its baseline fails
+    the comparison. See foamBenchMain().
+*/
+class FoamBench {
+
+    typedef std::map<std::string, double>   StringDoubleMap;
+
+public:
+
+    FoamBench(FOAM_UINT32 numRecords, FOAM_UINT32 numReps = 5) :
+        numRecords_(numRecords),
+        numReps_(numReps),
+        seed_(12345)
+    {
+    }
+
+    ~FoamBench()
+    {
+    }
+
+
+    //! Runs all benchmarks and appends their results.
+    bool
+    run(FoamBenchResultArray1 &results)
+    {
+        return benchComments(results) && benchHeader(results) &&
+            benchLabels(results) && benchFaces(results) &&
+            benchFixedFaces("quads", 4, results) &&
+            benchFixedFaces("tris", 3, results) && benchPoints(results) &&
+            benchAdjacency("adjacency", 0, results) &&
+            benchAdjacency("adjacency-1", 1, results);
+    }
+
+
+    //! Prints results as a table.
+    static void
+    print(FILE *fp, const FoamBenchResultArray1 &results)
+    {
+        std::fprintf(fp, "%-10s %10s %12s %12s %12s\n", "primitive",
+            "records", "bytes", "ns/record", "bytes/cycle");
+        for (size_t ii = 0; ii < results.size(); ++ii) {
+            const FoamBenchResult &res = results[ii];
+            std::fprintf(fp, "%-10s %10lu %12lu %12.2f %12.3f\n",
+                res.name.c_str(), static_cast<unsigned long>(res.records),
+                static_cast<unsigned long>(res.bytes), res.nsPerRecord(),
+                res.bytesPerCycle());
+        }
+    }
+
+
+    //! Saves the ns/record of each result as "name value" lines.
+    static bool
+    writeBaseline(const char *fileName, const FoamBenchResultArray1 &results)
+    {
+        FILE *fp = std::fopen(fileName, "w");
+        bool ret = (0 != fp);
+        if (ret) {
+            std::fprintf(fp, "# primitive ns/record\n");
+            for (size_t ii = 0; ii < results.size(); ++ii) {
+                std::fprintf(fp, "%s %.4f\n", results[ii].name.c_str(),
+                    results[ii].nsPerRecord());
+            }
+            ret = (0 == std::ferror(fp));
+            ret = (0 == std::fclose(fp)) && ret;
+        }
+        return ret;
+    }
+
+
+    //! Compares results to a baseline file. Prints one line per primitive.
+    //! Baselines are only comparable on the machine that wrote them. So, a
+    //! missing file skips the comparison with a message.
+    //! \return false if any primitive is more than thresholdPct percent
+    //! slower than its baseline.
+    static bool
+    compareBaseline(const char *fileName, const FoamBenchResultArray1 &results,
+        double thresholdPct, FILE *out)
+    {
+        StringDoubleMap baseline;
+        bool ret = true;
+        if (!readBaseline(fileName, baseline)) {
+            std::fprintf(out, "no baseline %s for this machine, skipping the "
+                "comparison. Save one with --write-baseline %s\n", fileName,
+                fileName);
+        }
+        else {
+            // Report every primitive, not just the first regression
+            for (size_t ii = 0; ii < results.size(); ++ii) {
+                ret = compareOne(results[ii], baseline, thresholdPct, out) &&
+                    ret;
+            }
+        }
+        return ret;
+    }
+
+private:
+
+    //! \return false if res is more than thresholdPct slower than baseline.
+    static bool
+    compareOne(const FoamBenchResult &res, const StringDoubleMap &baseline,
+        double thresholdPct, FILE *out)
+    {
+        StringDoubleMap::const_iterator it = baseline.find(res.name);
+        if (baseline.end() == it) {
+            std::fprintf(out, "%-10s no baseline\n", res.name.c_str());
+            return true;
+        }
+        const double pct = 100.0 * (res.nsPerRecord() / it->second - 1.0);
+        const bool ret = (pct <= thresholdPct);
+        std::fprintf(out, "%-10s %10.2f ns -> %10.2f ns %+7.1f%% %s\n",
+            res.name.c_str(), it->second, res.nsPerRecord(), pct,
+            (ret ? "ok" : "REGRESSION"));
+        return ret;
+    }
+
+
+    static bool
+    readBaseline(const char *fileName, StringDoubleMap &baseline)
+    {
+        FILE *fp = std::fopen(fileName, "r");
+        bool ret = (0 != fp);
+        if (ret) {
+            char line[256];
+            char name[128];
+            double val;
+            while (0 != std::fgets(line, sizeof(line), fp)) {
+                if (('#' != line[0]) &&
+                        (2 == std::sscanf(line, "%127s %lf", name, &val)) &&
+                        (0.0 < val)) {
+                    baseline[name] = val;
+                }
+            }
+            std::fclose(fp);
+        }
+        return ret;
+    }
+
+
+    //! A handler that discards the points.
+    class NullHandler : public PolyMeshHandler {
+    public:
+        virtual bool beginRead(FOAM_UINT32) { return true; }
+        virtual bool beginStep(FOAM_UINT32) { return true; }
+        virtual bool stepIncr(FOAM_UINT32) { return true; }
+        virtual bool endStep() { return true; }
+        virtual bool beginPoints(FOAM_UINT32) { return true; }
+        virtual bool pushPoints(FOAM_UINT32, const FoamPoint *,
+                        FOAM_UINT32) { return true; }
+        virtual bool endPoints() { return true; }
+        virtual bool beginFaces(FOAM_UINT32) { return true; }
+        virtual bool pushFaces(const FoamFace *, FOAM_UINT32) { return true; }
+        virtual bool endFaces() { return true; }
+    };
+
+
+    //! \return A repeatable pseudo random number in [0, 2^31).
+    inline FOAM_UINT32
+    nextRand()
+    {
+        seed_ = seed_ * 1103515245U + 12345U;
+        return (seed_ >> 1) & 0x7FFFFFFFU;
+    }
+
+
+    static std::string
+    header(const char *cls, const char *obj)
+    {
+        return std::string("FoamFile\n{\n    version     2.0;\n"
+            "    format      ascii;\n    class       ") + cls +
+            ";\n    location    \"constant/polyMesh\";\n    object      " +
+            obj + ";\n}\n// * * * * * * * * * * * * * * * * * * * * //\n\n";
+    }
+
+
+    //! Runs func numReps_ times and appends the fastest run to results.
+    template<typename Func>
+    bool
+    time(const char *name, FOAM_UINT64 records, FOAM_UINT64 bytes, Func func,
+        FoamBenchResultArray1 &results)
+    {
+        FoamBenchResult res;
+        res.name = name;
+        res.records = records;
+        res.bytes = bytes;
+        res.seconds = 0.0;
+        res.cycles = 0;
+        bool ret = true;
+        for (FOAM_UINT32 ii = 0; ii < numReps_ && ret; ++ii) {
+            const std::chrono::steady_clock::time_point t0 =
+                std::chrono::steady_clock::now();
+#if defined(FOAM_BENCH_RDTSC)
+            const FOAM_UINT64 c0 = FOAM_BENCH_RDTSC();
+#endif
+            ret = func();
+#if defined(FOAM_BENCH_RDTSC)
+            const FOAM_UINT64 cycles = FOAM_BENCH_RDTSC() - c0;
+#else
+            const FOAM_UINT64 cycles = 0;
+#endif
+            const double secs = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - t0).count();
+            if ((0 == ii) || (secs < res.seconds)) {
+                res.seconds = secs;
+                res.cycles = cycles;
+            }
+        }
+        if (ret) {
+            results.push_back(res);
+        }
+        return ret;
+    }
+
+
+    bool
+    benchComments(FoamBenchResultArray1 &results)
+    {
+        // The comments come before the header, so open() skips them all
+        std::string data;
+        for (FOAM_UINT32 ii = 0; ii < numRecords_; ++ii) {
+            if (0 == ii % 2) {
+                data += "// line comment with / and * chars 12345\n";
+            }
+            else {
+                data += "/* block comment ** with\n   two lines */\n";
+            }
+        }
+        data += header("labelList", "owner") + "0\n(\n)\n";
+        return time("comments", numRecords_, data.size(), [&]() {
+            LabelListFile file("owner");
+            return file.open(data.data(), data.size()); }, results);
+    }
+
+
+    bool
+    benchHeader(FoamBenchResultArray1 &results)
+    {
+        std::string data("FoamFile\n{\n    class       labelList;\n");
+        char line[64];
+        for (FOAM_UINT32 ii = 0; ii < numRecords_; ++ii) {
+            std::sprintf(line, "    key%lu      \"value %lu\";\n",
+                static_cast<unsigned long>(ii),
+                static_cast<unsigned long>(nextRand()));
+            data += line;
+        }
+        data += "}\n0\n(\n)\n";
+        return time("header", numRecords_, data.size(), [&]() {
+            LabelListFile file("owner");
+            return file.open(data.data(), data.size()); }, results);
+    }
+
+
+    bool
+    benchLabels(FoamBenchResultArray1 &results)
+    {
+        std::string data(header("labelList", "owner"));
+        char line[32];
+        std::sprintf(line, "%lu\n(\n", static_cast<unsigned long>(numRecords_));
+        data += line;
+        for (FOAM_UINT32 ii = 0; ii < numRecords_; ++ii) {
+            std::sprintf(line, "%lu\n", static_cast<unsigned long>(
+                nextRand() % 10000000));
+            data += line;
+        }
+        data += ")\n";
+        return time("labels", numRecords_, data.size(), [&]() {
+            LabelListFile file("owner");
+            bool ret = file.open(data.data(), data.size()) &&
+                (numRecords_ == file.getNumLabels());
+            FOAM_UINT32 lbl;
+            for (FOAM_UINT32 ii = 0; ii < numRecords_ && ret; ++ii) {
+                ret = file.readNextLabel(lbl);
+            }
+            return ret; }, results);
+    }
+
+
+    //! \return A faceList corpus. If vertCnt is 3 or 4, all faces have
+    //! vertCnt vertices. Otherwise, every 4th face is a tri and the others
+    //! are quads.
+    std::string
+    facesCorpus(FOAM_UINT32 vertCnt)
+    {
+        std::string data(header("faceList", "faces"));
+        char line[96];
+        std::sprintf(line, "%lu\n(\n", static_cast<unsigned long>(numRecords_));
+        data += line;
+        for (FOAM_UINT32 ii = 0; ii < numRecords_; ++ii) {
+            const bool isTri = (3 == vertCnt) ||
+                ((4 != vertCnt) && (0 == ii % 4));
+            if (isTri) {
+                std::sprintf(line, "3(%lu %lu %lu)\n",
+                    static_cast<unsigned long>(nextRand() % 10000000),
+                    static_cast<unsigned long>(nextRand() % 10000000),
+                    static_cast<unsigned long>(nextRand() % 10000000));
+            }
+            else {
+                std::sprintf(line, "4(%lu %lu %lu %lu)\n",
+                    static_cast<unsigned long>(nextRand() % 10000000),
+                    static_cast<unsigned long>(nextRand() % 10000000),
+                    static_cast<unsigned long>(nextRand() % 10000000),
+                    static_cast<unsigned long>(nextRand() % 10000000));
+            }
+            data += line;
+        }
+        data += ")\n";
+        return data;
+    }
+
+
+    //! Times reading the faces in data one at a time with readNextFace().
+    bool
+    timeNextFace(const char *name, const std::string &data,
+        FoamBenchResultArray1 &results)
+    {
+        return time(name, numRecords_, data.size(), [&]() {
+            FaceListFile file("faces");
+            bool ret = file.open(data.data(), data.size()) &&
+            (numRecords_ == file.getNumFaces());
+            FoamFace face;
+            for (FOAM_UINT32 ii = 0; ii < numRecords_ && ret; ++ii) {
+            ret = file.readNextFace(face);
+            }
+            return ret; }, results);
+    }
+
+
+    bool
+    benchFaces(FoamBenchResultArray1 &results)
+    {
+        const std::string data(facesCorpus(0));
+        return timeNextFace("faces", data, results);
+    }
+
+
+    //! Times the generic and the fixed-arity reads of faces that all have
+    //! vertCnt vertices. The fixed-arity result is named "<name>-fix".
+    bool
+    benchFixedFaces(const char *name, FOAM_UINT32 vertCnt,
+        FoamBenchResultArray1 &results)
+    {
+        const std::string data(facesCorpus(vertCnt));
+        const std::string fixName = std::string(name) + "-fix";
+        std::vector<FoamFace> faces(PolyMeshHandler::BatchSize);
+        return timeNextFace(name, data, results) &&
+            time(fixName.c_str(), numRecords_, data.size(), [&]() {
+                FaceListFile file("faces");
+                bool ret = file.open(data.data(), data.size()) &&
+                    (numRecords_ == file.getNumFaces());
+                // The detection is part of the timed read
+                const FOAM_UINT32 fileVertCnt = file.sampleVertCnt();
+                const FOAM_UINT32 batchSize =
+                    static_cast<FOAM_UINT32>(faces.size());
+                bool uniform = true;
+                for (FOAM_UINT32 ii = 0; ii < numRecords_ && ret;
+                        ii += batchSize) {
+                    ret = file.readFaces(&faces[0], std::min(batchSize,
+                        numRecords_ - ii), fileVertCnt, uniform) && uniform;
+                }
+                return ret; }, results);
+    }
+
+
+    bool
+    benchPoints(FoamBenchResultArray1 &results)
+    {
+        std::string data(header("vectorField", "points"));
+        char line[96];
+        std::sprintf(line, "%lu\n(\n", static_cast<unsigned long>(numRecords_));
+        data += line;
+        for (FOAM_UINT32 ii = 0; ii < numRecords_; ++ii) {
+            std::sprintf(line, "(%.17g %.17g %.17g)\n",
+                nextRand() / 2147483648.0, nextRand() / 2147483648.0 - 0.5,
+                nextRand() / 1024.0);
+            data += line;
+        }
+        data += ")\n";
+        return time("points", numRecords_, data.size(), [&]() {
+            VectorFieldFile file("points");
+            NullHandler handler;
+            return file.open(data.data(), data.size()) &&
+                (numRecords_ == file.getNumPts()) &&
+                file.read(handler); }, results);
+    }
+
+
+    //! Times building the adjacency of a hex block of about numRecords_
+    //! faces with a pool of numThreads. 0 uses all hardware threads.
+    bool
+    benchAdjacency(const char *name, FOAM_UINT32 numThreads,
+        FoamBenchResultArray1 &results)
+    {
+        // The labels of an n^3 block in OpenFOAM order. The interior faces
+        // are in upper triangular order followed by the boundary faces.
+        const FOAM_UINT32 n = std::max<FOAM_UINT32>(2, static_cast<FOAM_UINT32>(
+            std::pow(numRecords_ / 3.0, 1.0 / 3.0)));
+        FoamLabelArray1 owners;
+        FoamLabelArray1 neighbors;
+        for (FOAM_UINT32 cc = 0; cc < n * n * n; ++cc) {
+            const FOAM_UINT32 ijk[3] = { cc % n, (cc / n) % n, cc / (n * n) };
+            const FOAM_UINT32 step[3] = { 1, n, n * n };
+            for (int dd = 0; dd < 3; ++dd) {
+                if (ijk[dd] + 1 < n) {
+                    owners.push_back(cc);
+                    neighbors.push_back(cc + step[dd]);
+                }
+            }
+        }
+        for (FOAM_UINT32 cc = 0; cc < n * n * n; ++cc) {
+            const FOAM_UINT32 ijk[3] = { cc % n, (cc / n) % n, cc / (n * n) };
+            for (int dd = 0; dd < 3; ++dd) {
+                if (0 == ijk[dd]) {
+                    owners.push_back(cc);
+                }
+                if (n - 1 == ijk[dd]) {
+                    owners.push_back(cc);
+                }
+            }
+        }
+        FoamTaskPool pool(numThreads);
+        FoamTaskScope scope(&pool, FoamTaskPool::PollFunc());
+        return time(name, owners.size(), 4 * (owners.size() +
+            neighbors.size()), [&]() {
+                CellFaceCsr csr;
+                return csr.build(owners, neighbors) &&
+                    (n * n * n == csr.getNumCells()); }, results);
+    }
+
+private:
+    FoamBench(const FoamBench&);
+    const FoamBench& operator=(const FoamBench&);
+
+private:
+    FOAM_UINT32     numRecords_;    //!< The records in each corpus
+    FOAM_UINT32     numReps_;       //!< The runs of each benchmark
+    FOAM_UINT32     seed_;          //!< The nextRand() state
+};
+
+
+/*! Runs the benchmarks from the command line.
+
+        --records N          records per corpus (default 200000)
+        --reps N             runs per primitive (default 5)
+        --write-baseline F   save the results as baseline file F
+        --baseline F         compare the results to baseline file F. Skipped
+                             if F does not exist
+        --threshold PCT      max slowdown vs. the baseline (default 10)
+
+    \return 0 on success. 1 if a benchmark fails or a primitive regressed.
+*/
+inline int
+foamBenchMain(int argc, char *argv[])
+{
+    unsigned long numRecords = 200000;
+    unsigned long numReps = 5;
+    const char *writeFile = 0;
+    const char *baseFile = 0;
+    double threshold = 10.0;
+    for (int ii = 1; ii + 1 < argc; ii += 2) {
+        const char *val = argv[ii + 1];
+        if (0 == std::strcmp(argv[ii], "--records")) {
+            numRecords = std::strtoul(val, 0, 10);
+        }
+        else if (0 == std::strcmp(argv[ii], "--reps")) {
+            numReps = std::strtoul(val, 0, 10);
+        }
+        else if (0 == std::strcmp(argv[ii], "--write-baseline")) {
+            writeFile = val;
+        }
+        else if (0 == std::strcmp(argv[ii], "--baseline")) {
+            baseFile = val;
+        }
+        else if (0 == std::strcmp(argv[ii], "--threshold")) {
+            threshold = std::strtod(val, 0);
+        }
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[ii]);
+            return 1;
+        }
+    }
+    FoamBench bench(static_cast<FOAM_UINT32>(numRecords),
+        static_cast<FOAM_UINT32>((0 == numReps) ? 1 : numReps));
+    FoamBenchResultArray1 results;
+    bool ret = (0 != numRecords) && bench.run(results);
+    if (!ret) {
+        std::fprintf(stderr, "benchmark failed\n");
+        return 1;
+    }
+    FoamBench::print(stdout, results);
+    if (0 != writeFile) {
+        ret = FoamBench::writeBaseline(writeFile, results);
+    }
+    if (ret && (0 != baseFile)) {
+        ret = FoamBench::compareBaseline(baseFile, results, threshold,
+            stdout);
+    }
+    return ret ? 0 : 1;
+}
+
+#endif // FOAMBENCH_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
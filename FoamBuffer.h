@@ -0,0 +1,572 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMBUFFER_H
+#define FOAMBUFFER_H
+
+#include "FoamTypes.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A read-only, memory mapped view of an entire file.
+
+    The file is mapped with mmap() or MapViewOfFile(). If mapping fails, the
+    file contents are loaded into a heap buffer instead. Either way, begin()
+    and size() give random access to the whole file without any seeking.
+*/
+class FoamMappedFile {
+public:
+
+    FoamMappedFile() :
+        data_(0),
+        size_(0),
+        mapped_(false),
+        buf_()
+#if defined(_WIN32)
+        , hFile_(INVALID_HANDLE_VALUE),
+        hMap_(0)
+#endif
+    {
+    }
+
+    ~FoamMappedFile()
+    {
+        close();
+    }
+
+
+    //! Maps the named file (relative to cwd or absolute).
+    //! \return false if the file could not be opened or read.
+    bool
+    open(const char *fileName)
+    {
+        close();
+        return mapFile(fileName) || loadFile(fileName);
+    }
+
+
+    //! Releases the mapping or heap buffer.
+    void
+    close()
+    {
+        if (mapped_) {
+#if defined(_WIN32)
+            UnmapViewOfFile(data_);
+            CloseHandle(hMap_);
+            CloseHandle(hFile_);
+            hMap_ = 0;
+            hFile_ = INVALID_HANDLE_VALUE;
+#else
+            munmap(const_cast<char*>(data_), size_);
+#endif
+        }
+        std::vector<char>().swap(buf_);
+        data_ = 0;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+
+    //! \return The first byte of the file.
+    inline const char * begin() const {
+                            return data_; }
+
+    //! \return One past the last byte of the file.
+    inline const char * end() const {
+                            return data_ + size_; }
+
+    //! \return The file size in bytes.
+    inline size_t       size() const {
+                            return size_; }
+
+private:
+
+    bool
+    mapFile(const char *fileName)
+    {
+#if defined(_WIN32)
+        hFile_ = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (INVALID_HANDLE_VALUE == hFile_) {
+            return false;
+        }
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(hFile_, &sz) || (0 == sz.QuadPart) ||
+                (0 == (hMap_ = CreateFileMappingA(hFile_, 0, PAGE_READONLY, 0,
+                    0, 0)))) {
+            CloseHandle(hFile_);
+            hFile_ = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        data_ = static_cast<const char*>(MapViewOfFile(hMap_, FILE_MAP_READ,
+            0, 0, 0));
+        if (0 == data_) {
+            CloseHandle(hMap_);
+            CloseHandle(hFile_);
+            hMap_ = 0;
+            hFile_ = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        size_ = static_cast<size_t>(sz.QuadPart);
+#else
+        const int fd = ::open(fileName, O_RDONLY);
+        if (-1 == fd) {
+            return false;
+        }
+        struct stat st;
+        void *p = MAP_FAILED;
+        if ((0 == fstat(fd, &st)) && (0 < st.st_size)) {
+            p = mmap(0, static_cast<size_t>(st.st_size), PROT_READ,
+                MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (MAP_FAILED == p) {
+            return false;
+        }
+        // The data is parsed front to back
+        madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+        mapped_ = true;
+        return true;
+    }
+
+
+    bool
+    loadFile(const char *fileName)
+    {
+        FILE *fp = std::fopen(fileName, "rb");
+        bool ret = (0 != fp);
+        if (ret) {
+            char chunk[65536];
+            size_t cnt;
+            while (0 < (cnt = std::fread(chunk, 1, sizeof(chunk), fp))) {
+                buf_.insert(buf_.end(), chunk, chunk + cnt);
+            }
+            ret = (0 == std::ferror(fp));
+            std::fclose(fp);
+        }
+        if (ret) {
+            data_ = buf_.empty() ? 0 : &buf_[0];
+            size_ = buf_.size();
+        }
+        return ret;
+    }
+
+private:
+    FoamMappedFile(const FoamMappedFile&);
+    const FoamMappedFile& operator=(const FoamMappedFile&);
+
+private:
+    const char *        data_;      //!< The first byte of the file data
+    size_t              size_;      //!< The file data size in bytes
+    bool                mapped_;    //!< true if data_ is a file mapping
+    std::vector<char>   buf_;       //!< The heap copy if mapping failed
+#if defined(_WIN32)
+    HANDLE              hFile_;     //!< The mapped file handle
+    HANDLE              hMap_;      //!< The file mapping handle
+#endif
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A forward only cursor for parsing OpenFOAM data held in memory.
+
+    This is the in-memory counterpart of FoamFile. It never reads outside of
+    the [begin, end) range given to the constructor, so independent cursors
+    may safely parse different parts of the same FoamMappedFile on different
+    threads.
+*/
+class FoamBuffer {
+public:
+
+    typedef std::map<std::string, std::string>  StringStringMap;
+
+    FoamBuffer(const char *begin = 0, const char *end = 0) :
+        pos_(begin),
+        end_(end)
+    {
+    }
+
+
+    //! \return The current parse position.
+    inline const char * pos() const {
+                            return pos_; }
+
+    //! \return One past the last parsable byte.
+    inline const char * end() const {
+                            return end_; }
+
+    //! Moves the parse position. pos must be in the buffer's range.
+    inline void         setPos(const char *pos) {
+                            pos_ = pos; }
+
+    //! \return true if all chars have been consumed.
+    inline bool         atEnd() const {
+                            return pos_ >= end_; }
+
+
+    //! Discards all leading whitespace.
+    //! \return false if the end of the buffer is reached.
+    inline bool
+    wspaceSkip()
+    {
+        while ((pos_ < end_) &&
+                std::isspace(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return pos_ < end_;
+    }
+
+
+    //! Discards all leading whitespace and comments. The pos is left at the
+    //! first non white space or comment char.
+    //! \return false if an unterminated C style comment is found.
+    bool
+    wspaceCommentsSkip()
+    {
+        while (wspaceSkip() && ('/' == *pos_) && (pos_ + 1 < end_)) {
+            if ('/' == pos_[1]) {
+                // C++ style comment - discard rest of line.
+                const char *eol = static_cast<const char*>(
+                    std::memchr(pos_ + 2, '\n', end_ - pos_ - 2));
+                pos_ = (0 == eol) ? end_ : eol + 1;
+            }
+            else if ('*' == pos_[1]) {
+                // C style comment - discard all until end of comment.
+                const char *p = pos_ + 2;
+                while ((p + 1 < end_) && !(('*' == p[0]) && ('/' == p[1]))) {
+                    ++p;
+                }
+                if (p + 1 >= end_) {
+                    // C style comments must be closed.
+                    pos_ = end_;
+                    return false;
+                }
+                pos_ = p + 2;
+            }
+            else {
+                // Not a comment
+                break;
+            }
+        }
+        return true;
+    }
+
+
+    //! Discards whitespace and the next char if it is ch.
+    //! \return false if the next non white space char is not ch.
+    inline bool
+    wspaceSkipToChar(char ch)
+    {
+        const bool ret = wspaceSkip() && (ch == *pos_);
+        if (ret) {
+            ++pos_;
+        }
+        return ret;
+    }
+
+
+    //! \return true if only whitespace and comments remain.
+    inline bool
+    wspaceCommentsSkipToEnd()
+    {
+        return wspaceCommentsSkip() && atEnd();
+    }
+
+
+    //! Reads the next white space delimited token.
+    bool
+    readToken(std::string &tok)
+    {
+        const bool ret = wspaceSkip();
+        if (ret) {
+            const char *b = pos_;
+            while ((pos_ < end_) &&
+                    !std::isspace(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+            tok.assign(b, pos_);
+        }
+        return ret;
+    }
+
+
+    //! Reads all chars up to but not including ch into val and trims any
+    //! leading and trailing white space. The ch is consumed.
+    bool
+    readUntilTrim(std::string &val, char ch)
+    {
+        const char *b = pos_;
+        const char *e = static_cast<const char*>(std::memchr(b, ch, end_ - b));
+        if (0 == e) {
+            return false;
+        }
+        pos_ = e + 1;
+        while ((b < e) && std::isspace(static_cast<unsigned char>(*b))) {
+            ++b;
+        }
+        while ((b < e) && std::isspace(static_cast<unsigned char>(e[-1]))) {
+            --e;
+        }
+        val.assign(b, e);
+        return true;
+    }
+
+
+    //! Reads an unsigned integer value.
+    inline bool
+    readInt(FOAM_UINT32 &val)
+    {
+        bool ret = wspaceSkip() &&
+            std::isdigit(static_cast<unsigned char>(*pos_));
+        if (ret) {
+            // Stop accumulating once v overflows so it cannot wrap. The
+            // rest of the digits are still consumed.
+            FOAM_UINT64 v = 0;
+            do {
+                if (v <= FOAM_UINT32_MAX) {
+                    v = (v * 10) + static_cast<FOAM_UINT64>(*pos_ - '0');
+                }
+                ++pos_;
+            } while ((pos_ < end_) &&
+                std::isdigit(static_cast<unsigned char>(*pos_)));
+            val = static_cast<FOAM_UINT32>(v);
+            ret = (v <= FOAM_UINT32_MAX);
+        }
+        return ret;
+    }
+
+
+    //! Reads a signed integer value.
+    inline bool
+    readInt(FOAM_INT32 &val)
+    {
+        bool neg = false;
+        if (wspaceSkip() && (('-' == *pos_) || ('+' == *pos_))) {
+            neg = ('-' == *pos_);
+            ++pos_;
+        }
+        FOAM_UINT32 v;
+        const bool ret = readInt(v) && (v <= 0x7fffffffU);
+        if (ret) {
+            val = neg ? -static_cast<FOAM_INT32>(v) :
+                static_cast<FOAM_INT32>(v);
+        }
+        return ret;
+    }
+
+
+    //! Reads a floating point value.
+    bool
+    readDouble(double &val)
+    {
+        // Copy the number so strtod() cannot run past the end of the buffer.
+        char num[64];
+        size_t len = 0;
+        if (wspaceSkip()) {
+            while ((pos_ + len < end_) && (len < sizeof(num) - 1) &&
+                    (std::isalnum(static_cast<unsigned char>(pos_[len])) ||
+                     ('.' == pos_[len]) || ('-' == pos_[len]) ||
+                     ('+' == pos_[len]))) {
+                num[len] = pos_[len];
+                ++len;
+            }
+        }
+        num[len] = '\0';
+        char *endPtr;
+        val = std::strtod(num, &endPtr);
+        const bool ret = (0 < len) && (num + len == endPtr);
+        if (ret) {
+            pos_ += len;
+        }
+        return ret;
+    }
+
+
+    //! Reads a "(x y z)" vector.
+    inline bool
+    readVector(double &x, double &y, double &z)
+    {
+        return wspaceSkipToChar('(') && readDouble(x) && readDouble(y) &&
+            readDouble(z) && wspaceSkipToChar(')');
+    }
+
+
+    //! Reads a "FoamFile { key value; ... }" header into hdrVals. The pos is
+    //! left on the first non white space char after the header.
+    //! \sa FoamFile::readHeader()
+    bool
+    readHeader(StringStringMap &hdrVals)
+    {
+        std::string tok;
+        bool ret = wspaceCommentsSkip() && readToken(tok) &&
+            ("FoamFile" == tok) && wspaceSkipToChar('{') &&
+            wspaceCommentsSkip() && readToken(tok);
+        while (ret && ("}" != tok)) {
+            if (!readHeaderVal(hdrVals[tok])) {
+                ret = false;
+                break;
+            }
+            ret = wspaceCommentsSkip() && readToken(tok);
+        }
+        return ret && wspaceCommentsSkip();
+    }
+
+
+    //! Reads a header value up to its ; like readUntilTrim(). A ; inside
+    //! quotes, as in arch "LSB;label=32;scalar=64", does not end the value.
+    bool
+    readHeaderVal(std::string &val)
+    {
+        const char *b = pos_;
+        while ((b < end_) && std::isspace(static_cast<unsigned char>(*b))) {
+            ++b;
+        }
+        // The ; is searched for after the closing quote
+        const char *s = b;
+        if ((s < end_) && ('"' == *s)) {
+            s = static_cast<const char*>(std::memchr(s + 1, '"',
+                end_ - s - 1));
+            if (0 == s) {
+                return false;
+            }
+        }
+        const char *e = static_cast<const char*>(std::memchr(s, ';',
+            end_ - s));
+        if (0 == e) {
+            return false;
+        }
+        pos_ = e + 1;
+        while ((b < e) && std::isspace(static_cast<unsigned char>(e[-1]))) {
+            --e;
+        }
+        val.assign(b, e);
+        return true;
+    }
+
+
+    //! Reads an optional header. If the data does not start with a FoamFile
+    //! header, the pos is left on the first non white space or comment char.
+    bool
+    readOptionalHeader(StringStringMap &hdrVals)
+    {
+        bool ret = wspaceCommentsSkip();
+        if (ret && (8 <= (end_ - pos_)) &&
+                (0 == std::memcmp(pos_, "FoamFile", 8))) {
+            ret = readHeader(hdrVals);
+        }
+        return ret;
+    }
+
+
+    //! Reads the "N (" that starts a list and stores N in cnt.
+    inline bool
+    readListBegin(FOAM_UINT32 &cnt)
+    {
+        return wspaceCommentsSkip() && readInt(cnt) && wspaceSkipToChar('(');
+    }
+
+
+    //! Reads the ")" that ends a list and verifies only white space and
+    //! comments follow it.
+    inline bool
+    readListEnd()
+    {
+        return wspaceSkipToChar(')') && wspaceCommentsSkipToEnd();
+    }
+
+private:
+    const char *    pos_;   //!< The current parse position
+    const char *    end_;   //!< One past the last parsable byte
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Reads a "3(a b c)" or "4(a b c d)" face into data. Parser may be a
+    FoamBuffer or a FoamStream. Both provide readInt() and
+    wspaceSkipToChar(). A FoamFace holds at most 4 points and the grid
+    import only builds tri and quad faces, so faces with any other point
+    count are rejected.
+    \return false if the face could not be read or if an unsupported face
+    type is detected.
+*/
+template<typename Parser>
+inline bool
+foamReadFace(Parser &in, FoamFace &data)
+{
+    bool ret = in.readInt(data.vertCnt) && in.wspaceSkipToChar('(');
+    if (ret) {
+        switch (data.vertCnt) {
+        case 4:
+            // each face has form: "4(3 9 10 0)"
+            ret = in.readInt(data.index[0]) && in.readInt(data.index[1]) &&
+                in.readInt(data.index[2]) && in.readInt(data.index[3]) &&
+                in.wspaceSkipToChar(')');
+            break;
+        case 3:
+            // each face has form: "3(3 9 10)"
+            ret = in.readInt(data.index[0]) && in.readInt(data.index[1]) &&
+                in.readInt(data.index[2]) && in.wspaceSkipToChar(')');
+            break;
+        default:
+            // Polygon faces are not supported
+            ret = false;
+            break;
+        }
+    }
+    return ret;
+}
+
+#endif  // FOAMBUFFER_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
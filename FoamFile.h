@@ -16,11 +16,13 @@
 #ifndef FOAMFILE_H
 #define FOAMFILE_H
 
-#include "apiGRDPUtils.h"
-#include "PwpFile.h"
+#include "FoamArchive.h"
+#include "FoamStream.h"
+#include "FoamTypes.h"
 
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <functional> 
 #include <map>
 #include <string>
@@ -33,7 +35,7 @@
 
 /*! A base class for reading and parsing all OpenFOAM grid data files.
 */
-class FoamFile : public PwpFile {
+class FoamFile : public FoamStream {
     enum {
         DefReserve = 128    //!< The default size reserved for token strings
     };
@@ -45,6 +47,7 @@ protected:
     FoamFile(const char *baseName) :
         hdrVals_(),
         baseName_(baseName),
+        archive_(0),
         dataPos_()
     {
     }
@@ -56,16 +59,36 @@ public:
     {
     }
 
-    //! Opens the foam file (in cwd) and loads the header data.
-    inline bool     open() {
-                        // IMPORTANT! MUST use pwpBinary when opening file to
-                        // prevent platform EOL differences from breaking file
-                        // position handling.
-                        // Also, prior to passing control off to this plugin,
-                        // the SDK sets the cwd to the import folder location.
-                        // So, we can just open the file without a path!
-                        return PwpFile::open(baseName_, pwpRead | pwpBinary) &&
-                            readHeader(); }
+    //! Opens the foam file (in cwd or the archive) and loads the header data.
+    bool
+    open()
+    {
+        // FoamStream always opens files in binary mode to prevent platform
+        // EOL differences from breaking file position handling.
+        // Also, prior to passing control off to this plugin, the SDK sets the
+        // cwd to the import folder location. So, we can just open the file
+        // without a path!
+        const char *data;
+        size_t size;
+        const bool ret = (0 == archive_) ? FoamStream::open(baseName_) :
+            (archive_->find(baseName_, data, size) &&
+                FoamStream::open(data, size));
+        return ret && readHeader();
+    }
+
+    //! Opens the size bytes at data as the foam file and loads the header
+    //! data. The bytes are not copied and must remain valid until the file
+    //! is closed.
+    bool
+    open(const char *data, size_t size)
+    {
+        return FoamStream::open(data, size) && readHeader();
+    }
+
+    //! Reads the file from archive instead of the cwd. The archive must stay
+    //! open while the file is open. Pass 0 to read from the cwd again.
+    inline void     setArchive(const FoamArchive *archive) {
+                        archive_ = archive; }
 
     //! \return true if header key exists and is equal to expectedVal.
     inline bool     headerValIs(const char *key, const char *expectedVal) {
@@ -96,7 +119,7 @@ public:
             // C standard says ungetc() is only guaranteed to work once! To
             // properly restore the file pos if the second char is not a
             // comment, we must capture the rewind pos.
-            sysFILEPOS rewPos;
+            FilePos rewPos;
             if (!getPos(rewPos)) {
                 return false;
             }
@@ -168,7 +191,7 @@ public:
         while (ret && ("}" != tok)) {
             // hdrVals_[tok] creates an empty string value in the map. Load
             // trimmed value from the file up to but not including the ;
-            if (!readUntilTrim(hdrVals_[tok], ';')) {
+            if (!readHeaderVal(hdrVals_[tok])) {
                 ret = false;
                 break;
             }
@@ -209,6 +232,40 @@ public:
         return ret;
     }
 
+
+    //! Gets a "key:value" count from the header note. OpenFOAM writes a note
+    //! like "nPoints:45 nCells:8 nFaces:68 nInternalFaces:12" in the owner
+    //! and neighbour headers.
+    //! \return false if the note or key does not exist.
+    bool
+    getNoteVal(const char *key, FOAM_UINT32 &val)
+    {
+        std::string note;
+        bool ret = getHeaderVal("note", note);
+        if (ret) {
+            const std::string k = std::string(key) + ":";
+            std::string::size_type pos = note.find(k);
+            // Must be at start of note or preceded by a delimiter
+            while ((std::string::npos != pos) && (0 != pos) &&
+                    std::isalnum(static_cast<unsigned char>(note[pos - 1]))) {
+                pos = note.find(k, pos + 1);
+            }
+            ret = (std::string::npos != pos);
+            if (ret) {
+                const char *beg = note.c_str() + pos + k.size();
+                char *endPtr;
+                val = static_cast<FOAM_UINT32>(std::strtoul(beg, &endPtr, 10));
+                ret = (beg != endPtr);
+            }
+        }
+        return ret;
+    }
+
+
+    //! \return The file name given to the constructor.
+    inline const std::string &  getBaseName() const {
+                                    return baseName_; }
+
 protected:
     //! Caches the file's current pos. This pos should mark the first valid data
     //! char after the header. This is called by readHeader() prior to calling
@@ -236,9 +293,10 @@ private:
     virtual bool    afterReadHeader() = 0;
 
 private:
-    StringStringMap hdrVals_;
-    std::string     baseName_;
-    sysFILEPOS      dataPos_;
+    StringStringMap     hdrVals_;
+    std::string         baseName_;
+    const FoamArchive * archive_;   //!< The archive to read from or 0
+    FilePos             dataPos_;
 };
 
 #endif  // FOAMFILE_H
@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMPARALLEL_H
+#define FOAMPARALLEL_H
+
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+
+#include <algorithm>
+#include <string>
+
+
+//---------------------------------------------------------------------------
+
+//! \return The number of threads used by foamParallelFor(). Without a
+//! current pool, the loops are serial.
+inline static FOAM_UINT32
+foamNumThreads()
+{
+    const FoamTaskPool *pool = FoamTaskPool::current();
+    return (0 == pool) ? 1 : pool->getNumThreads();
+}
+
+
+//! \return The min items per range of stage from the current pool or
+//! defVal.
+inline static FOAM_UINT64
+foamTaskGrain(const char *stage, FOAM_UINT64 defVal)
+{
+    const FoamTaskPool *pool = FoamTaskPool::current();
+    return (0 == pool) ? defVal : pool->getGrain(stage, defVal);
+}
+
+
+/*! Splits [0, cnt) into one contiguous range per thread and calls
+    func(begin, end, rangeNdx) for each range concurrently. Returns after all
+    ranges are done. The number of ranges is at most foamNumThreads() and is
+    returned so callers can size per range accumulators.
+
+    The ranges run as tasks of the current FoamTaskPool. If the current pool
+    cancels the loop, the ranges that have not started are skipped and 0 is
+    returned. The caller must then discard the results.
+*/
+template<typename Func>
+FOAM_UINT32
+foamParallelFor(FOAM_UINT64 cnt, Func func, FOAM_UINT64 minPerRange = 4096)
+{
+    FoamCurrentPool current;
+    FoamTaskPool &pool = current.get();
+    FOAM_UINT64 numRanges = std::max<FOAM_UINT64>(1,
+        cnt / std::max<FOAM_UINT64>(1, minPerRange));
+    numRanges = std::min<FOAM_UINT64>(numRanges, pool.getNumThreads());
+    const FOAM_UINT64 perRange = (cnt + numRanges - 1) / numRanges;
+    FoamTaskPool::Group group;
+    for (FOAM_UINT64 ii = 1; ii < numRanges; ++ii) {
+        const FOAM_UINT64 beg = std::min(cnt, ii * perRange);
+        const FOAM_UINT64 end = std::min(cnt, beg + perRange);
+        const FOAM_UINT32 rng = static_cast<FOAM_UINT32>(ii);
+        pool.run(group, [&func, beg, end, rng]() { func(beg, end, rng); });
+    }
+    // The calling thread does the first range
+    func(FOAM_UINT64(0), std::min(cnt, perRange), FOAM_UINT32(0));
+    return pool.wait(group) ? static_cast<FOAM_UINT32>(numRanges) : 0;
+}
+
+#endif // FOAMPARALLEL_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,431 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMSTREAM_H
+#define FOAMSTREAM_H
+
+#include "FoamTypes.h"
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A buffered, read-only file with the character and token primitives used
+    by FoamFile.
+
+    Files are always read in binary mode to prevent platform EOL differences
+    from breaking file position handling. File positions are byte offsets.
+
+    A stream may also be opened on bytes already in memory, such as a member
+    of a mapped archive. The bytes are then read in place without copying.
+*/
+class FoamStream {
+    enum {
+        BufSize = 256 * 1024    //!< The read buffer size in bytes
+    };
+
+public:
+
+    typedef FOAM_UINT64     FilePos;    //!< A byte offset from file start
+
+    FoamStream() :
+        fp_(0),
+        buf_(BufSize),
+        data_(0),
+        bufPos_(0),
+        len_(0),
+        ndx_(0)
+    {
+    }
+
+    virtual ~FoamStream()
+    {
+        close();
+    }
+
+
+    //! Opens fileName for reading.
+    bool
+    open(const std::string &fileName)
+    {
+        close();
+        fp_ = std::fopen(fileName.c_str(), "rb");
+        data_ = (0 == fp_) ? 0 : &buf_[0];
+        return 0 != fp_;
+    }
+
+
+    //! Opens the size bytes at data for reading. The bytes are not copied
+    //! and must remain valid until the stream is closed.
+    bool
+    open(const char *data, size_t size)
+    {
+        close();
+        // The whole range is the buffer. So, fill() is never needed.
+        data_ = (0 == size) ? "" : data;
+        len_ = size;
+        return 0 != data_;
+    }
+
+
+    //! Closes the file.
+    void
+    close()
+    {
+        if (0 != fp_) {
+            std::fclose(fp_);
+            fp_ = 0;
+        }
+        data_ = 0;
+        bufPos_ = 0;
+        len_ = 0;
+        ndx_ = 0;
+    }
+
+
+    //! \return true if the file is open.
+    inline bool     isOpen() const {
+                        return 0 != data_; }
+
+
+    //! Reads the next char into c.
+    //! \return false if EOF is encountered.
+    inline bool
+    getcNotEOF(int &c)
+    {
+        const bool ret = (ndx_ < len_) || fill();
+        if (ret) {
+            c = static_cast<unsigned char>(data_[ndx_++]);
+        }
+        return ret;
+    }
+
+
+    //! Puts back the char returned by the most recent getcNotEOF().
+    inline bool
+    ungetc(int c)
+    {
+        (void)c;
+        const bool ret = (0 < ndx_);
+        if (ret) {
+            --ndx_;
+        }
+        return ret;
+    }
+
+
+    //! \return The next unread buffered char. The chars up to bufferEnd()
+    //! may be scanned in place. The buffer is not refilled.
+    inline const char * bufferPos() const {
+                            return data_ + ndx_; }
+
+    //! \return One past the last buffered char.
+    inline const char * bufferEnd() const {
+                            return data_ + len_; }
+
+    //! Marks the buffered chars before pos as read. pos must be in the range
+    //! [bufferPos(), bufferEnd()].
+    inline void         consumeTo(const char *pos) {
+                            ndx_ = static_cast<size_t>(pos - data_); }
+
+
+    //! Gets the current file pos.
+    inline bool
+    getPos(FilePos &pos) const
+    {
+        pos = bufPos_ + ndx_;
+        return isOpen();
+    }
+
+
+    //! Sets the current file pos.
+    bool
+    setPos(const FilePos &pos)
+    {
+        if ((pos >= bufPos_) && (pos <= bufPos_ + len_)) {
+            // pos is in the buffer
+            ndx_ = static_cast<size_t>(pos - bufPos_);
+            return true;
+        }
+        if (0 == fp_) {
+            // pos is past the end of the memory range
+            return false;
+        }
+        bufPos_ = pos;
+        len_ = 0;
+        ndx_ = 0;
+#if defined(_WIN32)
+        return 0 == _fseeki64(fp_, static_cast<__int64>(pos), SEEK_SET);
+#else
+        return 0 == fseeko(fp_, static_cast<off_t>(pos), SEEK_SET);
+#endif
+    }
+
+
+    //! Reads and discards all chars up to and including ch.
+    //! \return false if EOF is encountered.
+    bool
+    skipToChar(int ch)
+    {
+        int c;
+        while (getcNotEOF(c)) {
+            if (ch == c) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    //! Reads and discards all whitespace.
+    //! \return false if EOF is encountered.
+    inline bool
+    wspaceSkip()
+    {
+        int c;
+        while (getcNotEOF(c)) {
+            if (!std::isspace(c)) {
+                ungetc(c);
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    //! Reads and discards all whitespace and the next char.
+    //! \return false if the next non whitespace char is not ch.
+    inline bool
+    wspaceSkipToChar(int ch)
+    {
+        int c;
+        return wspaceSkip() && getcNotEOF(c) && (ch == c);
+    }
+
+
+    //! \return true if only whitespace remains.
+    inline bool
+    wspaceSkipToEOF()
+    {
+        return !wspaceSkip();
+    }
+
+
+    //! Reads the next whitespace delimited token.
+    bool
+    readToken(std::string &tok)
+    {
+        tok.clear();
+        int c;
+        bool ret = wspaceSkip();
+        while (ret && getcNotEOF(c)) {
+            if (std::isspace(c)) {
+                ungetc(c);
+                break;
+            }
+            tok += static_cast<char>(c);
+        }
+        return ret && !tok.empty();
+    }
+
+
+    //! \return true if the next token is tok.
+    inline bool
+    readTokenIs(const char *tok)
+    {
+        std::string val;
+        return readToken(val) && (val == tok);
+    }
+
+
+    //! \return true if the next run of alpha chars is tok.
+    bool
+    readAlphaTokenIs(const char *tok)
+    {
+        std::string val;
+        int c;
+        bool ret = wspaceSkip();
+        while (ret && getcNotEOF(c)) {
+            if (!std::isalpha(c)) {
+                ungetc(c);
+                break;
+            }
+            val += static_cast<char>(c);
+        }
+        return ret && (val == tok);
+    }
+
+
+    //! Reads all chars up to but not including ch into val. The ch is
+    //! consumed.
+    bool
+    readUntil(std::string &val, int ch)
+    {
+        val.clear();
+        int c;
+        while (getcNotEOF(c)) {
+            if (ch == c) {
+                return true;
+            }
+            val += static_cast<char>(c);
+        }
+        return false;
+    }
+
+
+    //! Same as readUntil() but leading and trailing white space is removed.
+    bool
+    readUntilTrim(std::string &val, int ch)
+    {
+        const bool ret = readUntil(val, ch);
+        if (ret) {
+            trim(val);
+        }
+        return ret;
+    }
+
+
+    //! Reads a header value up to its ; like readUntilTrim(). A ; inside
+    //! quotes, as in arch "LSB;label=32;scalar=64", does not end the value.
+    bool
+    readHeaderVal(std::string &val)
+    {
+        val.clear();
+        bool inQuotes = false;
+        int c;
+        while (getcNotEOF(c)) {
+            if ((';' == c) && !inQuotes) {
+                trim(val);
+                return true;
+            }
+            inQuotes = ('"' == c) ? !inQuotes : inQuotes;
+            val += static_cast<char>(c);
+        }
+        return false;
+    }
+
+
+    //! Reads an unsigned integer value.
+    inline bool
+    readInt(FOAM_UINT32 &val)
+    {
+        int c;
+        bool ret = wspaceSkip() && getcNotEOF(c);
+        if (ret && ('+' == c)) {
+            ret = getcNotEOF(c);
+        }
+        ret = ret && std::isdigit(c);
+        if (ret) {
+            FOAM_UINT64 v = static_cast<FOAM_UINT64>(c - '0');
+            while (getcNotEOF(c)) {
+                if (!std::isdigit(c)) {
+                    ungetc(c);
+                    break;
+                }
+                if (v <= FOAM_UINT32_MAX) {
+                    v = (v * 10) + static_cast<FOAM_UINT64>(c - '0');
+                }
+            }
+            val = static_cast<FOAM_UINT32>(v);
+            ret = (v <= FOAM_UINT32_MAX);
+        }
+        return ret;
+    }
+
+
+    //! Reads a signed integer value.
+    inline bool
+    readInt(FOAM_INT32 &val)
+    {
+        int c;
+        bool neg = false;
+        if (wspaceSkip() && getcNotEOF(c)) {
+            neg = ('-' == c);
+            if (!neg) {
+                ungetc(c);
+            }
+        }
+        FOAM_UINT32 v;
+        const bool ret = readInt(v) && (v <= 0x7FFFFFFFU);
+        if (ret) {
+            val = neg ? -static_cast<FOAM_INT32>(v) :
+                static_cast<FOAM_INT32>(v);
+        }
+        return ret;
+    }
+
+private:
+
+    //! Loads the next chunk of the file into the buffer.
+    bool
+    fill()
+    {
+        bool ret = (0 != fp_);
+        if (ret) {
+            bufPos_ += len_;
+            len_ = std::fread(&buf_[0], 1, buf_.size(), fp_);
+            ndx_ = 0;
+            ret = (0 < len_);
+        }
+        return ret;
+    }
+
+
+    //! Removes the leading and trailing white space of val.
+    static void
+    trim(std::string &val)
+    {
+        const char *ws = " \t\r\n\f\v";
+        const std::string::size_type beg = val.find_first_not_of(ws);
+        if (std::string::npos == beg) {
+            val.clear();
+        }
+        else {
+            val = val.substr(beg, val.find_last_not_of(ws) - beg + 1);
+        }
+    }
+
+private:
+    FoamStream(const FoamStream&);
+    const FoamStream& operator=(const FoamStream&);
+
+private:
+    FILE *              fp_;        //!< The file handle
+    std::vector<char>   buf_;       //!< The read buffer
+    const char *        data_;      //!< buf_ or the memory range being read
+    FilePos             bufPos_;    //!< The file pos of data_[0]
+    size_t              len_;       //!< The number of valid chars in data_
+    size_t              ndx_;       //!< The data_ index of the next char
+};
+
+#endif // FOAMSTREAM_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,502 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMTASKPOOL_H
+#define FOAMTASKPOOL_H
+
+#include "FoamTypes.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A work stealing pool of threads that runs groups of tasks.
+
+    Each worker has its own task queue. A worker runs the newest task of its
+    own queue first and steals the oldest task of another queue when its own
+    is empty. Tasks added by a thread outside the pool go to a shared queue
+    that all workers steal from.
+
+    The thread that waits for a group also runs tasks until the group is
+    done, so a pool of N threads has N - 1 workers. While it waits, it calls
+    a poll function at least every PollMs. If the poll returns false, the
+    group is cancelled and its tasks that have not started are skipped. The
+    poll always runs on the waiting thread, so it may safely call APIs that
+    are not thread safe, such as progress and abort checks.
+
+    A pool can be made current for a thread with FoamTaskScope. The parallel
+    stages of the reader use the current pool and its poll function. Each
+    stage may also have its own task granularity, set with setGrain().
+*/
+class FoamTaskPool {
+    enum {
+        PollMs = 10     //!< The max time between polls while waiting
+    };
+
+public:
+
+    typedef std::function<void()>   Task;       //!< A unit of work
+    typedef std::function<bool()>   PollFunc;   //!< Returns false to cancel
+
+    //! A set of tasks that are waited for together
+    class Group {
+    public:
+        Group() :
+            pending_(0),
+            cancelled_(false)
+        {
+        }
+
+        //! Skips the tasks of the group that have not started.
+        inline void     cancel() {
+                            cancelled_ = true; }
+
+        //! \return true if the group was cancelled. Long tasks may check
+        //! this to stop early.
+        inline bool     isCancelled() const {
+                            return cancelled_; }
+
+    private:
+        Group(const Group&);
+        const Group& operator=(const Group&);
+
+    private:
+        friend class FoamTaskPool;
+        std::atomic<FOAM_UINT64>    pending_;   //!< The tasks not yet done
+        std::atomic<bool>           cancelled_; //!< true if cancelled
+    };
+
+
+    //! Starts numThreads - 1 workers. 0 uses one thread per core. If a
+    //! worker cannot be started, the started ones are joined and the
+    //! std::system_error is rethrown.
+    explicit FoamTaskPool(FOAM_UINT32 numThreads = 0) :
+        numThreads_((0 == numThreads) ? hardwareThreads() : numThreads),
+        queues_(),
+        workers_(),
+        numQueued_(0),
+        stop_(false),
+        sleepMtx_(),
+        sleepCv_(),
+        doneMtx_(),
+        doneCv_(),
+        grains_()
+    {
+        // The last queue takes the tasks added from outside the pool
+        for (FOAM_UINT32 ii = 0; ii < numThreads_; ++ii) {
+            queues_.push_back(std::unique_ptr<Queue>(new Queue));
+        }
+        // Reserved so that only the thread construction can throw
+        workers_.reserve(numThreads_);
+        try {
+            for (FOAM_UINT32 ii = 0; ii + 1 < numThreads_; ++ii) {
+                workers_.push_back(std::thread(&FoamTaskPool::workerMain,
+                    this, static_cast<size_t>(ii)));
+            }
+        }
+        catch (...) {
+            stopWorkers();
+            throw;
+        }
+    }
+
+    ~FoamTaskPool()
+    {
+        stopWorkers();
+    }
+
+
+    //! \return The number of threads, including the waiting thread.
+    inline FOAM_UINT32  getNumThreads() const {
+                            return numThreads_; }
+
+
+    //! Adds task to group. It may start at once on any thread.
+    void
+    run(Group &group, const Task &task)
+    {
+        ++group.pending_;
+        // Counted before it is published, so take() never drives the count
+        // below zero
+        {
+            std::lock_guard<std::mutex> lock(sleepMtx_);
+            ++numQueued_;
+        }
+        Queue &queue = *queues_[queueIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            queue.items.push_back(Item(task, &group));
+        }
+        sleepCv_.notify_one();
+    }
+
+
+    /*! Runs tasks until all tasks of group are done. poll is called on this
+        thread once before the first task, after each task it runs and at
+        least every PollMs. If poll is empty, the poll of the current
+        FoamTaskScope is used.
+        \return false if the group was cancelled.
+    */
+    bool
+    wait(Group &group, const PollFunc &poll = PollFunc())
+    {
+        const PollFunc *pollFunc = poll ? &poll : currentPoll();
+        // So a group that finishes before its first poll is still cancelled
+        if ((0 != pollFunc) && *pollFunc && !(*pollFunc)()) {
+            group.cancel();
+        }
+        const size_t ndx = queueIndex();
+        while (0 != group.pending_) {
+            Item item;
+            if (take(ndx, item)) {
+                execute(item);
+            }
+            else {
+                std::unique_lock<std::mutex> lock(doneMtx_);
+                if (0 != group.pending_) {
+                    doneCv_.wait_for(lock, std::chrono::milliseconds(PollMs));
+                }
+            }
+            if ((0 != pollFunc) && *pollFunc && !group.cancelled_ &&
+                    !(*pollFunc)()) {
+                group.cancel();
+            }
+        }
+        return !group.cancelled_;
+    }
+
+
+    //! Sets the min items per task of a stage.
+    inline void     setGrain(const std::string &stage, FOAM_UINT64 grain) {
+                        grains_[stage] = grain; }
+
+    //! \return The min items per task of a stage or defVal if not set.
+    FOAM_UINT64
+    getGrain(const std::string &stage, FOAM_UINT64 defVal) const
+    {
+        std::map<std::string, FOAM_UINT64>::const_iterator it =
+            grains_.find(stage);
+        return (grains_.end() == it) ? defVal : it->second;
+    }
+
+
+    /*! Sets the stage grains from a "stage=grain,stage=grain" string.
+        \return false if any entry is not valid. The valid entries are set.
+    */
+    bool
+    setGrains(const std::string &grains)
+    {
+        bool ret = true;
+        std::string::size_type beg = 0;
+        while (beg < grains.size()) {
+            std::string::size_type end = grains.find(',', beg);
+            end = (std::string::npos == end) ? grains.size() : end;
+            const std::string entry = grains.substr(beg, end - beg);
+            const std::string::size_type eq = entry.find('=');
+            char *last = 0;
+            const FOAM_UINT64 grain = (std::string::npos == eq) ? 0 :
+                std::strtoull(entry.c_str() + eq + 1, &last, 10);
+            if ((0 != grain) && ('\0' == *last) && (0 < eq)) {
+                setGrain(entry.substr(0, eq), grain);
+            }
+            else {
+                ret = false;
+            }
+            beg = end + 1;
+        }
+        return ret;
+    }
+
+
+    //! \return The number of hardware threads (at least 1).
+    static FOAM_UINT32
+    hardwareThreads()
+    {
+        const FOAM_UINT32 cnt = std::thread::hardware_concurrency();
+        return (0 == cnt) ? 1 : cnt;
+    }
+
+
+    //! \return The current pool of this thread or 0.
+    static FoamTaskPool *&
+    current()
+    {
+        static thread_local FoamTaskPool *pool = 0;
+        return pool;
+    }
+
+
+    //! \return The current poll function of this thread or 0.
+    static const PollFunc *&
+    currentPoll()
+    {
+        static thread_local const PollFunc *poll = 0;
+        return poll;
+    }
+
+
+    //! Calls the current poll function of this thread.
+    //! \return false if the work should stop.
+    static bool
+    poll()
+    {
+        const PollFunc *pollFunc = currentPoll();
+        return (0 == pollFunc) || !*pollFunc || (*pollFunc)();
+    }
+
+private:
+
+    //! A task and the group it belongs to
+    struct Item {
+        Item() :
+            task(),
+            group(0)
+        {
+        }
+
+        Item(const Task &t, Group *g) :
+            task(t),
+            group(g)
+        {
+        }
+
+        Task    task;   //!< The work
+        Group * group;  //!< The group to notify when done
+    };
+
+    //! The tasks added by one thread
+    struct Queue {
+        std::mutex          mtx;    //!< Guards items
+        std::deque<Item>    items;  //!< The tasks not yet started
+    };
+
+
+    //! \return The queue of this thread. Threads outside the pool share the
+    //! last queue.
+    size_t
+    queueIndex() const
+    {
+        const std::pair<const FoamTaskPool*, size_t> &worker = workerId();
+        return (this == worker.first) ? worker.second : (queues_.size() - 1);
+    }
+
+
+    //! \return The pool and queue index of a worker thread.
+    static std::pair<const FoamTaskPool*, size_t> &
+    workerId()
+    {
+        static thread_local std::pair<const FoamTaskPool*, size_t> id(0, 0);
+        return id;
+    }
+
+
+    //! Takes the newest task of queue ndx or steals the oldest task of
+    //! another queue.
+    bool
+    take(size_t ndx, Item &item)
+    {
+        const size_t numQueues = queues_.size();
+        for (size_t ii = 0; ii < numQueues; ++ii) {
+            Queue &queue = *queues_[(ndx + ii) % numQueues];
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if (!queue.items.empty()) {
+                if (0 == ii) {
+                    item = queue.items.back();
+                    queue.items.pop_back();
+                }
+                else {
+                    item = queue.items.front();
+                    queue.items.pop_front();
+                }
+                --numQueued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    //! Runs the task unless its group was cancelled.
+    void
+    execute(Item &item)
+    {
+        Group &group = *item.group;
+        if (!group.cancelled_) {
+            item.task();
+        }
+        if (1 == group.pending_--) {
+            std::lock_guard<std::mutex> lock(doneMtx_);
+            doneCv_.notify_all();
+        }
+    }
+
+
+    void
+    workerMain(size_t ndx)
+    {
+        workerId() = std::make_pair(this, ndx);
+        // Parallel loops inside a task use this pool too
+        current() = this;
+        while (true) {
+            Item item;
+            if (take(ndx, item)) {
+                execute(item);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMtx_);
+            if (stop_) {
+                break;
+            }
+            if (0 == numQueued_) {
+                sleepCv_.wait(lock);
+            }
+        }
+    }
+
+
+    //! Stops and joins the started workers.
+    void
+    stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMtx_);
+            stop_ = true;
+        }
+        sleepCv_.notify_all();
+        for (size_t ii = 0; ii < workers_.size(); ++ii) {
+            workers_[ii].join();
+        }
+    }
+
+private:
+    FoamTaskPool(const FoamTaskPool&);
+    const FoamTaskPool& operator=(const FoamTaskPool&);
+
+private:
+    typedef std::vector<std::unique_ptr<Queue> >    QueueArray1;
+
+    FOAM_UINT32                 numThreads_;    //!< The workers + 1
+    QueueArray1                 queues_;        //!< One per worker + shared
+    std::vector<std::thread>    workers_;       //!< The worker threads
+    std::atomic<FOAM_UINT64>    numQueued_;     //!< The tasks not started
+    bool                        stop_;          //!< true if shutting down
+    std::mutex                  sleepMtx_;      //!< Guards idle workers
+    std::condition_variable     sleepCv_;       //!< Wakes idle workers
+    std::mutex                  doneMtx_;       //!< Guards group completion
+    std::condition_variable     doneCv_;        //!< Wakes waiting threads
+    std::map<std::string, FOAM_UINT64>
+                                grains_;        //!< The stage task grains
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Makes a pool and poll function current for this thread until the scope
+    ends. Either may be 0 or empty.
+*/
+class FoamTaskScope {
+public:
+
+    FoamTaskScope(FoamTaskPool *pool, const FoamTaskPool::PollFunc &poll) :
+        prevPool_(FoamTaskPool::current()),
+        prevPoll_(FoamTaskPool::currentPoll()),
+        poll_(poll)
+    {
+        FoamTaskPool::current() = pool;
+        FoamTaskPool::currentPoll() = &poll_;
+    }
+
+    ~FoamTaskScope()
+    {
+        FoamTaskPool::current() = prevPool_;
+        FoamTaskPool::currentPoll() = prevPoll_;
+    }
+
+private:
+    FoamTaskScope(const FoamTaskScope&);
+    const FoamTaskScope& operator=(const FoamTaskScope&);
+
+private:
+    FoamTaskPool *                      prevPool_;  //!< The outer pool
+    const FoamTaskPool::PollFunc *      prevPoll_;  //!< The outer poll
+    FoamTaskPool::PollFunc              poll_;      //!< This scope's poll
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The current pool of this thread. If there is none, a pool without
+    workers is used, so the work runs serially on the calling thread and no
+    threads are started per call.
+*/
+class FoamCurrentPool {
+public:
+
+    FoamCurrentPool() :
+        current_(FoamTaskPool::current()),
+        local_(1)
+    {
+    }
+
+    ~FoamCurrentPool()
+    {
+    }
+
+
+    //! \return The pool to use.
+    inline FoamTaskPool &
+                    get() {
+                        return (0 == current_) ? local_ : *current_; }
+
+private:
+    FoamCurrentPool(const FoamCurrentPool&);
+    const FoamCurrentPool& operator=(const FoamCurrentPool&);
+
+private:
+    FoamTaskPool *  current_;   //!< The current pool or 0
+    FoamTaskPool    local_;     //!< The serial pool without workers
+};
+
+#endif // FOAMTASKPOOL_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
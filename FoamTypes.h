@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef FOAMTYPES_H
+#define FOAMTYPES_H
+
+#include <cstddef>
+#include <stdint.h>
+
+
+/*! \file
+    The basic types of the polyMesh reader core.
+
+    The reader core (all headers except runtimeReadGrid.cxx) does not depend
+    on the PluginSDK. It can be compiled into other applications as-is.
+*/
+
+typedef int32_t     FOAM_INT32;
+typedef uint32_t    FOAM_UINT32;
+typedef int64_t     FOAM_INT64;
+typedef uint64_t    FOAM_UINT64;
+
+#define FOAM_UINT32_MAX     0xFFFFFFFFU
+
+
+//! The face types passed to PolyMeshHandler::pushFaces()
+enum FOAM_FACETYPE {
+    FOAM_FACETYPE_BOUNDARY,     //!< A face with an owner cell only
+    FOAM_FACETYPE_INTERIOR      //!< A face with owner and neighbor cells
+};
+
+
+//! The zone types passed to PolyMeshHandler::pushZones()
+enum FOAM_ZONETYPE {
+    FOAM_ZONETYPE_CELL,         //!< A cellZones entry
+    FOAM_ZONETYPE_FACE,         //!< A faceZones entry
+    FOAM_ZONETYPE_POINT         //!< A pointZones entry
+};
+
+
+//! A point
+struct FoamPoint {
+    double          x;
+    double          y;
+    double          z;
+};
+
+
+//! A tri or quad face and its cells
+struct FoamFace {
+    FOAM_FACETYPE   type;       //!< The face type
+    FOAM_UINT32     owner;      //!< The owner cell index
+    FOAM_UINT32     neighbor;   //!< The neighbor cell index (interior only)
+    FOAM_UINT32     vertCnt;    //!< The number of used index values (3 or 4)
+    FOAM_UINT32     index[4];   //!< The face's point indices
+    FOAM_UINT32     id;         //!< The face's index in the faces file
+};
+
+#endif // FOAMTYPES_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
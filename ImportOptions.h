@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef IMPORTOPTIONS_H
+#define IMPORTOPTIONS_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The optional import behaviors.
+
+    runtimeReadGrid() has no way to receive user options, so they are read
+    from PW_OPENFOAM_* environment variables when the import starts.
+*/
+struct ImportOptions {
+
+    ImportOptions() :
+        prescan(getBool("PW_OPENFOAM_PRESCAN", false)),
+        qualityReport(getString("PW_OPENFOAM_QUALITY_REPORT")),
+        preloadMB(getUInt("PW_OPENFOAM_PRELOAD_MB", 512)),
+        cellOrder(getBool("PW_OPENFOAM_CELL_ORDER", false)),
+        compactPoints(getBool("PW_OPENFOAM_COMPACT_POINTS", false)),
+        cellZoneBlocks(getBool("PW_OPENFOAM_CELL_ZONE_BLOCKS", false)),
+        faceZoneBaffles(getBool("PW_OPENFOAM_FACE_ZONE_BAFFLES", false)),
+        archive(getString("PW_OPENFOAM_ARCHIVE")),
+        archiveMeshDir(getString("PW_OPENFOAM_ARCHIVE_MESH")),
+        arena(getBool("PW_OPENFOAM_ARENA", false)),
+        hugePages(getBool("PW_OPENFOAM_HUGE_PAGES", false)),
+        memoryReport(getString("PW_OPENFOAM_MEMORY_REPORT")),
+        numThreads(getUInt("PW_OPENFOAM_THREADS", 0)),
+        taskGrains(getString("PW_OPENFOAM_TASK_GRAIN"))
+    {
+    }
+
+
+    //! \return The value of env var name. defVal if not set.
+    static bool
+    getBool(const char *name, bool defVal)
+    {
+        const char *val = std::getenv(name);
+        if ((0 == val) || ('\0' == *val)) {
+            return defVal;
+        }
+        return (0 != std::strcmp(val, "0")) && (0 != std::strcmp(val, "off"))
+            && (0 != std::strcmp(val, "false"));
+    }
+
+
+    //! \return The value of env var name. defVal if not set or invalid.
+    static unsigned long
+    getUInt(const char *name, unsigned long defVal)
+    {
+        const char *val = std::getenv(name);
+        if ((0 == val) || ('\0' == *val)) {
+            return defVal;
+        }
+        char *end;
+        const unsigned long ret = std::strtoul(val, &end, 10);
+        return ('\0' == *end) ? ret : defVal;
+    }
+
+
+    //! \return The value of env var name. Empty if not set.
+    static std::string
+    getString(const char *name)
+    {
+        const char *val = std::getenv(name);
+        return (0 == val) ? std::string() : std::string(val);
+    }
+
+
+    //! Verify the file structure before importing (PW_OPENFOAM_PRESCAN)
+    bool            prescan;
+
+    //! Write mesh quality metrics to this file if not empty
+    //! (PW_OPENFOAM_QUALITY_REPORT)
+    std::string     qualityReport;
+
+    //! The max MB used to preload the owner and neighbour labels. 0 disables
+    //! preloading. (PW_OPENFOAM_PRELOAD_MB)
+    unsigned long   preloadMB;
+
+    //! Push the faces grouped by cell. Needs the labels to fit in preloadMB.
+    //! (PW_OPENFOAM_CELL_ORDER)
+    bool            cellOrder;
+
+    //! Drop the points not used by any face. The used points are marked in
+    //! a bitmap as the faces are read. (PW_OPENFOAM_COMPACT_POINTS)
+    bool            compactPoints;
+
+    //! Import each non-empty cellZone as its own block and the cells not in
+    //! any cellZone as one more block (PW_OPENFOAM_CELL_ZONE_BLOCKS)
+    bool            cellZoneBlocks;
+
+    //! Import each interior face in a faceZone as two boundary faces, one
+    //! for each of its cells (PW_OPENFOAM_FACE_ZONE_BAFFLES)
+    bool            faceZoneBaffles;
+
+    //! Read the polyMesh from this .tar or .tar.gz file instead of the cwd
+    //! if not empty. A relative path is relative to the import folder.
+    //! (PW_OPENFOAM_ARCHIVE)
+    std::string     archive;
+
+    //! The polyMesh directory in the archive. Found automatically if empty.
+    //! (PW_OPENFOAM_ARCHIVE_MESH)
+    std::string     archiveMeshDir;
+
+    //! Reserve one arena sized from the header counts for all staging
+    //! buffers (PW_OPENFOAM_ARENA)
+    bool            arena;
+
+    //! Use transparent huge pages for the arena where supported
+    //! (PW_OPENFOAM_HUGE_PAGES)
+    bool            hugePages;
+
+    //! Write the arena reserved, used and heap fallback bytes to this file if
+    //! not empty (PW_OPENFOAM_MEMORY_REPORT)
+    std::string     memoryReport;
+
+    //! The thread pool size. 0 uses one thread per core. Read when the
+    //! plugin is loaded. (PW_OPENFOAM_THREADS)
+    unsigned long   numThreads;
+
+    //! The min items per task of each parallel stage as
+    //! "stage=count,stage=count". Read when the plugin is loaded.
+    //! (PW_OPENFOAM_TASK_GRAIN)
+    std::string     taskGrains;
+};
+
+#endif // IMPORTOPTIONS_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
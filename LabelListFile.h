@@ -16,10 +16,9 @@
 #ifndef LABELLISTFILE_H
 #define LABELLISTFILE_H
 
+#include "FoamArena.h"
 #include "FoamFile.h"
-
-#include "apiGRDPUtils.h"
-#include "apiPWP.h"
+#include "FoamTypes.h"
 
 
 //---------------------------------------------------------------------------
@@ -43,14 +42,29 @@ public:
 
 
     //! Gets the number of label items in the file.
-    inline PWP_UINT32   getNumLabels() const {
+    inline FOAM_UINT32  getNumLabels() const {
                             return numLbls_; }
 
 
     //! Reads the next label item from the file.
-    inline bool         readNextLabel(PWP_UINT32 &lbl) {
+    inline bool         readNextLabel(FOAM_UINT32 &lbl) {
                             return readInt(lbl); }
 
+
+    //! Reads all remaining labels into lbls in one sequential pass and
+    //! verifies that only the closing ) and white space follow.
+    bool
+    readAllLabels(FoamLabelArray1 &lbls)
+    {
+        lbls.resize(numLbls_);
+        bool ret = true;
+        for (FOAM_UINT32 ii = 0; ii < numLbls_ && ret; ++ii) {
+            ret = readInt(lbls[ii]);
+        }
+        return ret && wspaceSkipToChar(')') && wspaceCommentsSkip() &&
+            wspaceSkipToEOF();
+    }
+
 private:
     //! Validate header values, capture total label count, leave file pos on
     //! first char after (, and re-mark data begin position.
@@ -73,7 +87,7 @@ private:
 
 
 private:
-    PWP_UINT32  numLbls_;   //!< The number of label items in the file
+    FOAM_UINT32  numLbls_;   //!< The number of label items in the file
 };
 
 #endif // LABELLISTFILE_H
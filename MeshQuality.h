@@ -0,0 +1,688 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef MESHQUALITY_H
+#define MESHQUALITY_H
+
+#include "FoamParallel.h"
+#include "FoamTypes.h"
+#include "PolyMeshHandler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Computes mesh quality metrics as the mesh passes through to another
+    handler.
+
+    All calls are forwarded unchanged to the next handler. The points are
+    copied because the faces only refer to them by index. Each face is split
+    into the triangles (p0, p1, p2) and (p0, p2, p3). A tri face is handled
+    as a quad whose fourth point is the first, so its second triangle is
+    empty. Each batch of faces is split into ranges that a branch free
+    kernel processes concurrently. It writes each face's share of its cells'
+    volume and centroid sums to structure of arrays buffers, which are then
+    added to the per cell sums. No face geometry is kept. Only the cells and
+    points of the interior faces are kept for the face metrics.
+
+    The cell volume and centroid use the pyramid decomposition with the
+    apex at the first point. A triangle t with area vector St and centroid
+    ct adds St . ct / 3 to the volume of the cell it points out of and
+    3/4 ct times that volume to the cell's centroid sum. The sums are exact
+    for any apex, so they match the OpenFOAM decomposition about the cell's
+    estimated center.
+
+    After the last face, the cells and then the interior faces are computed
+    in parallel over contiguous ranges and the per range results are
+    merged. The metrics are:
+      * face area
+      * cell volume
+      * face non-orthogonality: the angle between the face area vector and
+        the line joining the centroids of the face's two cells
+      * face skewness: the distance from the area weighted face center to
+        where the line joining the cell centroids crosses the face plane,
+        relative to the length of that line
+
+    Faces are reported by their index in the faces file and cells by their
+    OpenFOAM labels. The worst cells of a face metric are the distinct cells
+    of its worst faces, worst first.
+*/
+class MeshQuality : public PolyMeshHandler {
+
+    typedef std::vector<double>         DoubleArray1;
+    typedef std::vector<FOAM_UINT32>    UInt32Array1;
+    typedef std::vector<FOAM_UINT64>    UInt64Array1;
+
+    enum {
+        NumWorstFaces = 10, //!< The worst faces kept by a face metric
+        NumWorstCells = 5   //!< The worst cells reported by a face metric
+    };
+
+    //! The face area vector and center sums of one triangle
+    struct Tri {
+        double  s[3];       //!< The area vector
+        double  c[3];       //!< The centroid
+        double  vol3;       //!< 3 times the signed volume of its pyramid
+    };
+
+    //! The cells and points of an interior face
+    struct InteriorFace {
+        FOAM_UINT32     owner;      //!< The cell the face points into
+        FOAM_UINT32     neighbor;   //!< The cell the face points out of
+        FOAM_UINT32     id;         //!< The face's index in the faces file
+        FOAM_UINT32     index[4];   //!< The points. A tri repeats the first.
+    };
+
+    typedef std::vector<InteriorFace>   InteriorFaceArray1;
+
+    //! A value and the position of its interior face
+    struct Worst {
+        double          val;        //!< The metric value
+        FOAM_UINT32     pos;        //!< The index in interior_
+
+        //! \return true if this is worse than rhs. Ties favor the first.
+        bool
+        operator<(const Worst &rhs) const
+        {
+            return (val > rhs.val) || ((val == rhs.val) && (pos < rhs.pos));
+        }
+    };
+
+    typedef std::vector<Worst>  WorstArray1;
+
+    //! The min, max, histogram and worst items of a single metric
+    struct Stats {
+        Stats(double binWidth = 0.0, FOAM_UINT32 numBins = 0,
+                FOAM_UINT32 numWorst = 0) :
+            min(HUGE_VAL),
+            max(-HUGE_VAL),
+            sum(0.0),
+            cnt(0),
+            minNdx(FOAM_UINT32_MAX),
+            maxNdx(FOAM_UINT32_MAX),
+            binWidth(binWidth),
+            hist(numBins, 0),
+            numWorst(numWorst),
+            worst()
+        {
+        }
+
+        //! Adds val of item ndx. The interior face pos is kept if val is
+        //! among the numWorst largest values.
+        void
+        add(double val, FOAM_UINT32 ndx, FOAM_UINT32 pos = 0)
+        {
+            if (val < min) {
+                min = val;
+                minNdx = ndx;
+            }
+            if (val > max) {
+                max = val;
+                maxNdx = ndx;
+            }
+            sum += val;
+            ++cnt;
+            if (!hist.empty()) {
+                // the last bin collects everything beyond the others
+                const double bin = std::max(0.0, val / binWidth);
+                ++hist[std::min(static_cast<size_t>(bin), hist.size() - 1)];
+            }
+            if (0 != numWorst) {
+                const Worst item = { val, pos };
+                addWorst(item);
+            }
+        }
+
+        void
+        merge(const Stats &rhs)
+        {
+            // Ties favor the lower item so the result does not depend on
+            // the ranges
+            if ((rhs.min < min) ||
+                    ((rhs.min == min) && (rhs.minNdx < minNdx))) {
+                min = rhs.min;
+                minNdx = rhs.minNdx;
+            }
+            if ((rhs.max > max) ||
+                    ((rhs.max == max) && (rhs.maxNdx < maxNdx))) {
+                max = rhs.max;
+                maxNdx = rhs.maxNdx;
+            }
+            sum += rhs.sum;
+            cnt += rhs.cnt;
+            for (size_t ii = 0; ii < hist.size(); ++ii) {
+                hist[ii] += rhs.hist[ii];
+            }
+            for (size_t ii = 0; ii < rhs.worst.size(); ++ii) {
+                addWorst(rhs.worst[ii]);
+            }
+        }
+
+        //! Keeps item if it is among the numWorst worst items.
+        void
+        addWorst(const Worst &item)
+        {
+            if ((worst.size() < numWorst) || (item < worst.back())) {
+                worst.insert(std::upper_bound(worst.begin(), worst.end(),
+                    item), item);
+                if (worst.size() > numWorst) {
+                    worst.pop_back();
+                }
+            }
+        }
+
+        double          min;        //!< The smallest value
+        double          max;        //!< The largest value
+        double          sum;        //!< The sum of all values
+        FOAM_UINT64     cnt;        //!< The number of values
+        FOAM_UINT32     minNdx;     //!< The item with the smallest value
+        FOAM_UINT32     maxNdx;     //!< The item with the largest value
+        double          binWidth;   //!< The width of each histogram bin
+        UInt64Array1    hist;       //!< The histogram bin counts
+        size_t          numWorst;   //!< The max number of worst items
+        WorstArray1     worst;      //!< The worst items, worst first
+    };
+
+    typedef std::vector<Stats>  StatsArray1;
+
+public:
+
+    MeshQuality(PolyMeshHandler &next) :
+        next_(next),
+        xyz_(),
+        numFaces_(0),
+        interior_(),
+        cellSums_(),
+        numCells_(0),
+        faceAreaStats_(),
+        cellVolStats_(),
+        nonOrthoStats_(10.0, 10, NumWorstFaces),
+        skewStats_(0.5, 9, NumWorstFaces),
+        numNegVol_(0),
+        soa_(4 * BatchSize)
+    {
+    }
+
+    virtual ~MeshQuality()
+    {
+    }
+
+
+    virtual bool
+    beginRead(FOAM_UINT32 numSteps)
+    {
+        return next_.beginRead(numSteps);
+    }
+
+
+    virtual bool
+    beginStep(FOAM_UINT32 total)
+    {
+        return next_.beginStep(total);
+    }
+
+
+    virtual bool
+    stepIncr(FOAM_UINT32 cnt)
+    {
+        return next_.stepIncr(cnt);
+    }
+
+
+    virtual bool
+    endStep()
+    {
+        return next_.endStep();
+    }
+
+
+    virtual bool
+    isAborted()
+    {
+        return next_.isAborted();
+    }
+
+
+    virtual bool
+    beginPoints(FOAM_UINT32 numPts)
+    {
+        xyz_.resize(3 * static_cast<size_t>(numPts));
+        return next_.beginPoints(numPts);
+    }
+
+
+    virtual bool
+    pushPoints(FOAM_UINT32 first, const FoamPoint *pts, FOAM_UINT32 cnt)
+    {
+        bool ret = (3 * (static_cast<size_t>(first) + cnt) <= xyz_.size());
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            double *xyz = &xyz_[3 * (static_cast<size_t>(first) + ii)];
+            xyz[0] = pts[ii].x;
+            xyz[1] = pts[ii].y;
+            xyz[2] = pts[ii].z;
+        }
+        return ret && next_.pushPoints(first, pts, cnt);
+    }
+
+
+    virtual bool
+    endPoints()
+    {
+        // Use coordinates relative to the first point to reduce round off in
+        // the volume sums of meshes far from the origin.
+        if (3 <= xyz_.size()) {
+            const double org[3] = { xyz_[0], xyz_[1], xyz_[2] };
+            for (size_t ii = 0; ii < xyz_.size(); ++ii) {
+                xyz_[ii] -= org[ii % 3];
+            }
+        }
+        return next_.endPoints();
+    }
+
+
+    virtual bool
+    pushZones(const FoamZone *zones, FOAM_UINT32 cnt)
+    {
+        return next_.pushZones(zones, cnt);
+    }
+
+
+    virtual bool
+    beginFaces(FOAM_UINT32 numFaces)
+    {
+        numFaces_ = numFaces;
+        return next_.beginFaces(numFaces);
+    }
+
+
+    virtual bool
+    pushFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        return computeFaces(faces, cnt) && next_.pushFaces(faces, cnt);
+    }
+
+
+    virtual bool
+    endFaces()
+    {
+        return next_.endFaces() && finish();
+    }
+
+
+    //! Writes the metrics to fileName as text.
+    bool
+    writeReport(const char *fileName) const
+    {
+        FILE *fp = std::fopen(fileName, "w");
+        bool ret = (0 != fp);
+        if (ret) {
+            std::fprintf(fp, "OpenFOAM mesh quality\n");
+            std::fprintf(fp, "points              %lu\n",
+                static_cast<unsigned long>(xyz_.size() / 3));
+            std::fprintf(fp, "faces               %lu (%lu interior)\n",
+                static_cast<unsigned long>(numFaces_),
+                static_cast<unsigned long>(interior_.size()));
+            std::fprintf(fp, "cells               %lu\n\n",
+                static_cast<unsigned long>(numCells_));
+            writeStats(fp, "face area", "face", faceAreaStats_);
+            writeStats(fp, "cell volume", "cell", cellVolStats_);
+            std::fprintf(fp, "  negative volumes  %lu\n\n",
+                static_cast<unsigned long>(numNegVol_));
+            writeStats(fp, "non-orthogonality (deg)", "face", nonOrthoStats_);
+            writeWorstCells(fp, nonOrthoStats_);
+            writeHistogram(fp, nonOrthoStats_);
+            writeStats(fp, "skewness", "face", skewStats_);
+            writeWorstCells(fp, skewStats_);
+            writeHistogram(fp, skewStats_);
+            ret = (0 == std::ferror(fp));
+            ret = (0 == std::fclose(fp)) && ret;
+        }
+        return ret;
+    }
+
+private:
+
+    //! Splits the face with points p into 2 triangles. The pyramid volumes
+    //! use the first point as the apex.
+    static void
+    splitFace(const double *p[4], Tri &t0, Tri &t1)
+    {
+        const double a[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1],
+            p[1][2] - p[0][2] };
+        const double b[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1],
+            p[2][2] - p[0][2] };
+        const double c[3] = { p[3][0] - p[0][0], p[3][1] - p[0][1],
+            p[3][2] - p[0][2] };
+        t0.s[0] = 0.5 * (a[1] * b[2] - a[2] * b[1]);
+        t0.s[1] = 0.5 * (a[2] * b[0] - a[0] * b[2]);
+        t0.s[2] = 0.5 * (a[0] * b[1] - a[1] * b[0]);
+        t1.s[0] = 0.5 * (b[1] * c[2] - b[2] * c[1]);
+        t1.s[1] = 0.5 * (b[2] * c[0] - b[0] * c[2]);
+        t1.s[2] = 0.5 * (b[0] * c[1] - b[1] * c[0]);
+        for (int kk = 0; kk < 3; ++kk) {
+            t0.c[kk] = (p[0][kk] + p[1][kk] + p[2][kk]) / 3.0;
+            t1.c[kk] = (p[0][kk] + p[2][kk] + p[3][kk]) / 3.0;
+        }
+        t0.vol3 = t0.s[0] * t0.c[0] + t0.s[1] * t0.c[1] + t0.s[2] * t0.c[2];
+        t1.vol3 = t1.s[0] * t1.c[0] + t1.s[1] * t1.c[1] + t1.s[2] * t1.c[2];
+    }
+
+
+    //! Gets the points of face. \return false if a point does not exist.
+    bool
+    getPoints(const FOAM_UINT32 index[4], const double *p[4]) const
+    {
+        const size_t numPts = xyz_.size() / 3;
+        bool ret = true;
+        for (int kk = 0; kk < 4; ++kk) {
+            ret = ret && (index[kk] < numPts);
+            p[kk] = ret ? &xyz_[3 * static_cast<size_t>(index[kk])] : 0;
+        }
+        return ret;
+    }
+
+
+    /*! Computes the area and cell sums of each face in the batch in
+        parallel, then adds the sums to the face's cells. The interior faces
+        are kept for finish().
+    */
+    bool
+    computeFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        // The cell volume and x, y, z centroid sums of each face
+        double *vol3 = &soa_[0];
+        double *cx = &soa_[BatchSize];
+        double *cy = &soa_[2 * BatchSize];
+        double *cz = &soa_[3 * BatchSize];
+        bool ret = (cnt <= BatchSize);
+        FOAM_UINT32 maxCell = 0;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            const bool isInterior = (FOAM_FACETYPE_INTERIOR == faces[ii].type);
+            maxCell = std::max(maxCell, faces[ii].owner);
+            maxCell = isInterior ? std::max(maxCell, faces[ii].neighbor) :
+                maxCell;
+            // A cell label cannot reach the face count
+            ret = (faces[ii].id < numFaces_) && (maxCell < numFaces_) &&
+                (3 <= faces[ii].vertCnt) && (faces[ii].vertCnt <= 4);
+        }
+        const FOAM_UINT64 grain = foamTaskGrain("quality", 1024);
+        StatsArray1 areaStats(foamNumThreads());
+        std::vector<char> rangeOk(foamNumThreads(), 1);
+        const FOAM_UINT32 numRanges = !ret ? 0 : foamParallelFor(cnt,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            Stats &stats = areaStats[rng];
+            for (FOAM_UINT64 ii = beg; ii < end; ++ii) {
+                const FoamFace &face = faces[ii];
+                const FOAM_UINT32 index[4] = { face.index[0], face.index[1],
+                    face.index[2], face.index[(4 == face.vertCnt) ? 3 : 0] };
+                const double *p[4];
+                if (!getPoints(index, p)) {
+                    rangeOk[rng] = 0;
+                    break;
+                }
+                Tri t0;
+                Tri t1;
+                splitFace(p, t0, t1);
+                const double s[3] = { t0.s[0] + t1.s[0], t0.s[1] + t1.s[1],
+                    t0.s[2] + t1.s[2] };
+                stats.add(std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]),
+                    face.id);
+                vol3[ii] = t0.vol3 + t1.vol3;
+                cx[ii] = 0.75 * (t0.vol3 * t0.c[0] + t1.vol3 * t1.c[0]);
+                cy[ii] = 0.75 * (t0.vol3 * t0.c[1] + t1.vol3 * t1.c[1]);
+                cz[ii] = 0.75 * (t0.vol3 * t0.c[2] + t1.vol3 * t1.c[2]);
+            }
+        }, grain);
+        ret = (0 != numRanges);
+        for (FOAM_UINT32 ii = 0; ii < numRanges; ++ii) {
+            ret = ret && (0 != rangeOk[ii]);
+            faceAreaStats_.merge(areaStats[ii]);
+        }
+        if (ret && (4 * static_cast<size_t>(maxCell) >= cellSums_.size())) {
+            cellSums_.resize(4 * (static_cast<size_t>(maxCell) + 1), 0.0);
+        }
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            // The face points out of the neighbor and into the owner
+            const FoamFace &face = faces[ii];
+            double *owner = &cellSums_[4 * static_cast<size_t>(face.owner)];
+            owner[0] -= vol3[ii];
+            owner[1] -= cx[ii];
+            owner[2] -= cy[ii];
+            owner[3] -= cz[ii];
+            if (FOAM_FACETYPE_INTERIOR == face.type) {
+                double *nbr =
+                    &cellSums_[4 * static_cast<size_t>(face.neighbor)];
+                nbr[0] += vol3[ii];
+                nbr[1] += cx[ii];
+                nbr[2] += cy[ii];
+                nbr[3] += cz[ii];
+                const InteriorFace data = { face.owner, face.neighbor,
+                    face.id, { face.index[0], face.index[1], face.index[2],
+                    face.index[(4 == face.vertCnt) ? 3 : 0] } };
+                interior_.push_back(data);
+            }
+        }
+        return ret;
+    }
+
+
+    //! Computes the cells from their sums and the interior face metrics.
+    bool
+    finish()
+    {
+        numCells_ = static_cast<FOAM_UINT32>(cellSums_.size() / 4);
+
+        // Replace the sums by the volume and centroid of each cell
+        const FOAM_UINT64 grain = foamTaskGrain("quality", 4096);
+        StatsArray1 volStats(foamNumThreads(), cellVolStats_);
+        std::vector<FOAM_UINT64> negCnt(foamNumThreads(), 0);
+        const FOAM_UINT32 numCellRanges = foamParallelFor(numCells_,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            for (FOAM_UINT64 cc = beg; cc < end; ++cc) {
+                double *cell = &cellSums_[4 * static_cast<size_t>(cc)];
+                const double vol3 = cell[0];
+                if (0.0 != vol3) {
+                    cell[1] /= vol3;
+                    cell[2] /= vol3;
+                    cell[3] /= vol3;
+                }
+                cell[0] = vol3 / 3.0;
+                volStats[rng].add(cell[0], static_cast<FOAM_UINT32>(cc));
+                if (cell[0] <= 0.0) {
+                    ++negCnt[rng];
+                }
+            }
+        }, grain);
+        if (0 == numCellRanges) {
+            // cancelled
+            return false;
+        }
+        for (FOAM_UINT32 ii = 0; ii < numCellRanges; ++ii) {
+            cellVolStats_.merge(volStats[ii]);
+            numNegVol_ += negCnt[ii];
+        }
+
+        // Compute the interior face stats
+        StatsArray1 orthoStats(foamNumThreads(), nonOrthoStats_);
+        StatsArray1 skewStats(foamNumThreads(), skewStats_);
+        const FOAM_UINT32 numFaceRanges = foamParallelFor(interior_.size(),
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            for (FOAM_UINT64 ff = beg; ff < end; ++ff) {
+                faceStats(static_cast<FOAM_UINT32>(ff), orthoStats[rng],
+                    skewStats[rng]);
+            }
+        }, grain);
+        for (FOAM_UINT32 ii = 0; ii < numFaceRanges; ++ii) {
+            nonOrthoStats_.merge(orthoStats[ii]);
+            skewStats_.merge(skewStats[ii]);
+        }
+        return 0 != numFaceRanges;
+    }
+
+
+    //! Adds the metrics of interior face pos. A face of a cell without
+    //! volume is skipped.
+    void
+    faceStats(FOAM_UINT32 pos, Stats &orthoStats, Stats &skewStats) const
+    {
+        const InteriorFace &face = interior_[pos];
+        const double *co = &cellSums_[4 * static_cast<size_t>(face.owner)];
+        const double *cn = &cellSums_[4 * static_cast<size_t>(face.neighbor)];
+        const double *p[4];
+        if ((0.0 == co[0]) || (0.0 == cn[0]) || !getPoints(face.index, p)) {
+            return;
+        }
+        ++co;
+        ++cn;
+        Tri t0;
+        Tri t1;
+        splitFace(p, t0, t1);
+        const double sf[3] = { t0.s[0] + t1.s[0], t0.s[1] + t1.s[1],
+            t0.s[2] + t1.s[2] };
+        const double area = std::sqrt(sf[0] * sf[0] + sf[1] * sf[1] +
+            sf[2] * sf[2]);
+        // The area weighted center of the 2 triangles
+        const double a0 = std::sqrt(t0.s[0] * t0.s[0] + t0.s[1] * t0.s[1] +
+            t0.s[2] * t0.s[2]);
+        const double a1 = std::sqrt(t1.s[0] * t1.s[0] + t1.s[1] * t1.s[1] +
+            t1.s[2] * t1.s[2]);
+        if ((0.0 == area) || (0.0 == a0 + a1)) {
+            return;
+        }
+        double cf[3];
+        for (int kk = 0; kk < 3; ++kk) {
+            cf[kk] = (a0 * t0.c[kk] + a1 * t1.c[kk]) / (a0 + a1);
+        }
+        // The face normal points from the neighbor to the owner cell
+        const double d[3] = { co[0] - cn[0], co[1] - cn[1], co[2] - cn[2] };
+        const double dLen = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        const double dDotSf = d[0] * sf[0] + d[1] * sf[1] + d[2] * sf[2];
+        if (0.0 == dLen) {
+            return;
+        }
+        const double cosAngle = std::max(-1.0, std::min(1.0,
+            dDotSf / (dLen * area)));
+        orthoStats.add(std::acos(cosAngle) * 180.0 / 3.14159265358979323846,
+            face.id, pos);
+        if (0.0 != dDotSf) {
+            // Where the line joining the cell centers crosses the face plane
+            const double t = ((cf[0] - cn[0]) * sf[0] +
+                (cf[1] - cn[1]) * sf[1] + (cf[2] - cn[2]) * sf[2]) / dDotSf;
+            const double e[3] = { cf[0] - (cn[0] + t * d[0]),
+                cf[1] - (cn[1] + t * d[1]), cf[2] - (cn[2] + t * d[2]) };
+            skewStats.add(std::sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]) /
+                dLen, face.id, pos);
+        }
+    }
+
+
+    static void
+    writeStats(FILE *fp, const char *name, const char *item,
+        const Stats &stats)
+    {
+        std::fprintf(fp, "%s\n", name);
+        if (0 == stats.cnt) {
+            std::fprintf(fp, "  none\n");
+            return;
+        }
+        std::fprintf(fp, "  min               %.6g (%s %lu)\n", stats.min,
+            item, static_cast<unsigned long>(stats.minNdx));
+        std::fprintf(fp, "  max               %.6g (%s %lu)\n", stats.max,
+            item, static_cast<unsigned long>(stats.maxNdx));
+        std::fprintf(fp, "  average           %.6g\n",
+            stats.sum / static_cast<double>(stats.cnt));
+    }
+
+
+    //! Writes the distinct cells of the worst faces of stats, worst first.
+    //! A cell's value is that of its worst face.
+    void
+    writeWorstCells(FILE *fp, const Stats &stats) const
+    {
+        UInt32Array1 cells;
+        for (size_t ii = 0; ii < stats.worst.size(); ++ii) {
+            const InteriorFace &face = interior_[stats.worst[ii].pos];
+            const FOAM_UINT32 faceCells[2] = { face.owner, face.neighbor };
+            for (int kk = 0; kk < 2; ++kk) {
+                if ((cells.size() < size_t(NumWorstCells)) && (cells.end() ==
+                        std::find(cells.begin(), cells.end(), faceCells[kk]))) {
+                    cells.push_back(faceCells[kk]);
+                    std::fprintf(fp, "  worst cell        %.6g (cell %lu)\n",
+                        stats.worst[ii].val,
+                        static_cast<unsigned long>(faceCells[kk]));
+                }
+            }
+        }
+    }
+
+
+    static void
+    writeHistogram(FILE *fp, const Stats &stats)
+    {
+        for (size_t ii = 0; ii < stats.hist.size(); ++ii) {
+            const double lo = stats.binWidth * static_cast<double>(ii);
+            if (ii + 1 < stats.hist.size()) {
+                std::fprintf(fp, "  [%6g, %6g)  %lu\n", lo,
+                    lo + stats.binWidth,
+                    static_cast<unsigned long>(stats.hist[ii]));
+            }
+            else {
+                std::fprintf(fp, "  [%6g,    inf)  %lu\n", lo,
+                    static_cast<unsigned long>(stats.hist[ii]));
+            }
+        }
+        std::fprintf(fp, "\n");
+    }
+
+private:
+    MeshQuality(const MeshQuality&);
+    const MeshQuality& operator=(const MeshQuality&);
+
+private:
+    PolyMeshHandler &   next_;          //!< The handler receiving all data
+    DoubleArray1        xyz_;           //!< The points
+    FOAM_UINT32         numFaces_;      //!< The number of faces
+    InteriorFaceArray1  interior_;      //!< The interior faces
+    DoubleArray1        cellSums_;      //!< The volume and centroid of each
+                                        //!< cell, or their sums until finish
+    FOAM_UINT32         numCells_;      //!< The number of cells
+    Stats               faceAreaStats_; //!< The face area metric
+    Stats               cellVolStats_;  //!< The cell volume metric
+    Stats               nonOrthoStats_; //!< The non-orthogonality metric
+    Stats               skewStats_;     //!< The skewness metric
+    FOAM_UINT64         numNegVol_;     //!< The number of cells with vol <= 0
+    DoubleArray1        soa_;           //!< The computeFaces() buffers
+};
+
+#endif // MESHQUALITY_H
+
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,354 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef POINTCOMPACTOR_H
+#define POINTCOMPACTOR_H
+
+#include "FoamArena.h"
+#include "FoamParallel.h"
+#include "FoamTypes.h"
+#include "PolyMeshHandler.h"
+#include "ZoneListFile.h"
+
+#include <atomic>
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Drops the points that no face uses as the mesh passes through to another
+    handler.
+
+    All faces must be passed to markFaces() before any points are pushed.
+    The caller streams them in batches, either from a first pass over the
+    faces file or as the faces are loaded, so the faces need not be kept.
+    The faces of each batch are split into ranges that set the bits of
+    their points in a shared bitmap concurrently. A bit is set with an
+    atomic or, and only if it is still clear.
+
+    endMark() then counts the used points before each 64 bit bitmap word
+    with a prefix sum. It runs in parallel and each thread owns a range of
+    words, so no locking is needed. A used point's new index is the count
+    of its word plus the used points before it in the word. So, only 1.5
+    bits are stored per point.
+
+    The next handler then only receives the used points. The face point
+    indices and point zone labels are renumbered to match. All other calls
+    are forwarded unchanged. A mesh whose faces use no point is rejected.
+
+    The word counts are stored in the arena if one is given.
+*/
+class PointCompactor : public PolyMeshHandler {
+
+    typedef std::atomic<FOAM_UINT64>    AtomicWord;
+    typedef std::vector<AtomicWord>     AtomicWordArray1;
+    typedef std::vector<FOAM_UINT64>    UInt64Array1;
+    typedef std::vector<FoamPoint>      PointArray1;
+    typedef std::vector<FoamFace>       FaceArray1;
+
+public:
+
+    PointCompactor(PolyMeshHandler &next, FoamArena *arena = 0) :
+        next_(next),
+        numPts_(0),
+        used_(),
+        wordBase_(FoamArenaAllocator<FOAM_UINT32>(arena)),
+        numUsed_(0),
+        pts_(),
+        faces_()
+    {
+    }
+
+    virtual ~PointCompactor()
+    {
+    }
+
+
+    //! Starts marking the used points of a mesh with numPts points.
+    void
+    beginMark(FOAM_UINT32 numPts)
+    {
+        const size_t numWords = (static_cast<size_t>(numPts) + 63) / 64;
+        AtomicWordArray1(numWords).swap(used_);
+        for (size_t ii = 0; ii < numWords; ++ii) {
+            used_[ii].store(0, std::memory_order_relaxed);
+        }
+        wordBase_.clear();
+        numPts_ = numPts;
+        numUsed_ = 0;
+    }
+
+
+    //! Marks the points used by cnt faces in parallel.
+    //! \return false if a face uses a point index >= numPts or if the
+    //! marking was cancelled.
+    bool
+    markFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        const FOAM_UINT64 grain = foamTaskGrain("compact", 1024);
+        std::vector<char> rangeOk(foamNumThreads(), 1);
+        const FOAM_UINT32 numRanges = foamParallelFor(cnt,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            for (FOAM_UINT64 ii = beg; ii < end; ++ii) {
+                const FoamFace &face = faces[ii];
+                for (FOAM_UINT32 jj = 0; jj < face.vertCnt; ++jj) {
+                    const FOAM_UINT32 pt = face.index[jj];
+                    if (numPts_ <= pt) {
+                        rangeOk[rng] = 0;
+                        return;
+                    }
+                    // Most points are shared by several faces. Skipping the
+                    // write of a set bit avoids contending for its word.
+                    AtomicWord &word = used_[pt / 64];
+                    const FOAM_UINT64 bit = FOAM_UINT64(1) << (pt % 64);
+                    if (0 == (word.load(std::memory_order_relaxed) & bit)) {
+                        word.fetch_or(bit, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }, grain);
+        bool ret = (0 != numRanges);
+        for (FOAM_UINT32 ii = 0; ii < numRanges; ++ii) {
+            ret = ret && (0 != rangeOk[ii]);
+        }
+        return ret;
+    }
+
+
+    //! Numbers the marked points in order.
+    //! \return false if the numbering was cancelled or no point is used.
+    bool
+    endMark()
+    {
+        const FOAM_UINT64 numWords = used_.size();
+        const FOAM_UINT64 grain = foamTaskGrain("compact", 4096) / 64 + 1;
+        wordBase_.resize(static_cast<size_t>(numWords));
+        // Count the used points of each range
+        UInt64Array1 rangeCnt(foamNumThreads() + 1, 0);
+        const FOAM_UINT32 numRanges = foamParallelFor(numWords,
+                [&](FOAM_UINT64 beg, FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT64 cnt = 0;
+            for (FOAM_UINT64 ww = beg; ww < end; ++ww) {
+                cnt += popCount(used_[ww].load(std::memory_order_relaxed));
+            }
+            rangeCnt[rng + 1] = cnt;
+        }, grain);
+        if (0 == numRanges) {
+            // cancelled
+            return false;
+        }
+        for (FOAM_UINT32 ii = 1; ii <= numRanges; ++ii) {
+            rangeCnt[ii] += rangeCnt[ii - 1];
+        }
+        // Count the used points before each word of a range after those of
+        // the prior ranges. The same ranges are produced for the same word
+        // count.
+        const bool ret = 0 != foamParallelFor(numWords, [&](FOAM_UINT64 beg,
+                FOAM_UINT64 end, FOAM_UINT32 rng) {
+            FOAM_UINT64 base = rangeCnt[rng];
+            for (FOAM_UINT64 ww = beg; ww < end; ++ww) {
+                wordBase_[ww] = static_cast<FOAM_UINT32>(base);
+                base += popCount(used_[ww].load(std::memory_order_relaxed));
+            }
+        }, grain);
+        numUsed_ = static_cast<FOAM_UINT32>(rangeCnt[numRanges]);
+        return ret && (0 != numUsed_);
+    }
+
+
+    //! \return The number of points used by the faces.
+    inline FOAM_UINT32  getNumUsed() const {
+                            return numUsed_; }
+
+
+    virtual bool
+    beginRead(FOAM_UINT32 numSteps)
+    {
+        return next_.beginRead(numSteps);
+    }
+
+
+    virtual bool
+    beginStep(FOAM_UINT32 total)
+    {
+        return next_.beginStep(total);
+    }
+
+
+    virtual bool
+    stepIncr(FOAM_UINT32 cnt)
+    {
+        return next_.stepIncr(cnt);
+    }
+
+
+    virtual bool
+    endStep()
+    {
+        return next_.endStep();
+    }
+
+
+    virtual bool
+    isAborted()
+    {
+        return next_.isAborted();
+    }
+
+
+    virtual bool
+    beginPoints(FOAM_UINT32 numPts)
+    {
+        pts_.reserve(BatchSize);
+        return (numPts == numPts_) && (0 != numUsed_) &&
+            next_.beginPoints(numUsed_);
+    }
+
+
+    virtual bool
+    pushPoints(FOAM_UINT32 first, const FoamPoint *pts, FOAM_UINT32 cnt)
+    {
+        if (numPts_ < static_cast<FOAM_UINT64>(first) + cnt) {
+            return false;
+        }
+        // The used points of a batch are numbered consecutively
+        FOAM_UINT32 newFirst = FOAM_UINT32_MAX;
+        pts_.clear();
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            const FOAM_UINT32 ndx = newIndex(first + ii);
+            if (FOAM_UINT32_MAX != ndx) {
+                newFirst = pts_.empty() ? ndx : newFirst;
+                pts_.push_back(pts[ii]);
+            }
+        }
+        return pts_.empty() || next_.pushPoints(newFirst, &pts_[0],
+            static_cast<FOAM_UINT32>(pts_.size()));
+    }
+
+
+    virtual bool
+    endPoints()
+    {
+        return next_.endPoints();
+    }
+
+
+    virtual bool
+    pushZones(const FoamZone *zones, FOAM_UINT32 cnt)
+    {
+        // Renumber the point zones. Unused points are dropped. The labels
+        // stay sorted because the renumbering keeps the point order.
+        FoamZoneArray1 newZones(zones, zones + cnt);
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            FoamZone &zone = newZones[ii];
+            if (FOAM_ZONETYPE_POINT != zone.type) {
+                continue;
+            }
+            size_t numKept = 0;
+            for (size_t jj = 0; jj < zone.labels.size(); ++jj) {
+                const FOAM_UINT32 ndx = newIndex(zone.labels[jj]);
+                if (FOAM_UINT32_MAX != ndx) {
+                    zone.labels[numKept++] = ndx;
+                }
+            }
+            zone.labels.resize(numKept);
+        }
+        return (0 == cnt) || next_.pushZones(&newZones[0], cnt);
+    }
+
+
+    virtual bool
+    beginFaces(FOAM_UINT32 numFaces)
+    {
+        faces_.resize(BatchSize);
+        return next_.beginFaces(numFaces);
+    }
+
+
+    virtual bool
+    pushFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        bool ret = (cnt <= faces_.size());
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            FoamFace &face = faces_[ii];
+            face = faces[ii];
+            for (FOAM_UINT32 jj = 0; jj < face.vertCnt; ++jj) {
+                face.index[jj] = newIndex(face.index[jj]);
+            }
+        }
+        return ret && ((0 == cnt) || next_.pushFaces(&faces_[0], cnt));
+    }
+
+
+    virtual bool
+    endFaces()
+    {
+        return next_.endFaces();
+    }
+
+private:
+
+    //! \return The number of set bits in word.
+    static inline FOAM_UINT64
+    popCount(FOAM_UINT64 word)
+    {
+        word -= (word >> 1) & 0x5555555555555555ULL;
+        word = (word & 0x3333333333333333ULL) +
+            ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (word * 0x0101010101010101ULL) >> 56;
+    }
+
+
+    //! \return The new index of point pt or FOAM_UINT32_MAX if it is not
+    //! used. pt must be a point of the mesh.
+    inline FOAM_UINT32
+    newIndex(FOAM_UINT32 pt) const
+    {
+        const FOAM_UINT64 word = used_[pt / 64].load(std::memory_order_relaxed);
+        const FOAM_UINT64 bit = FOAM_UINT64(1) << (pt % 64);
+        return (0 == (word & bit)) ? FOAM_UINT32_MAX : (wordBase_[pt / 64] +
+            static_cast<FOAM_UINT32>(popCount(word & (bit - 1))));
+    }
+
+private:
+    PointCompactor(const PointCompactor&);
+    const PointCompactor& operator=(const PointCompactor&);
+
+private:
+    PolyMeshHandler &   next_;      //!< The handler receiving the used data
+    FOAM_UINT32         numPts_;    //!< The number of points
+    AtomicWordArray1    used_;      //!< The bit of each used point is set
+    FoamLabelArray1     wordBase_;  //!< The used points before each word
+    FOAM_UINT32         numUsed_;   //!< The number of used points
+    PointArray1         pts_;       //!< The used points of a batch
+    FaceArray1          faces_;     //!< The renumbered faces of a batch
+};
+
+#endif // POINTCOMPACTOR_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
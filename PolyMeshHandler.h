@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef POLYMESHHANDLER_H
+#define POLYMESHHANDLER_H
+
+#include "FoamTypes.h"
+
+struct FoamZone;
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The receiver of the data produced by PolyMeshReader.
+
+    PolyMeshReader calls the handler from the thread that called
+    PolyMeshReader::read(). The points and faces are passed in batches. The
+    batch arrays are only valid for the duration of the call.
+
+    The call sequence is:
+
+        beginRead()
+            beginStep() stepIncr()... endStep()         // once per step
+        beginPoints() pushPoints()... endPoints()       // inside a step
+        pushZones()                                     // if any zones
+        beginFaces()  pushFaces()...  endFaces()        // inside a step
+
+    Every method returns false to stop the read. PolyMeshReader::read() then
+    returns false.
+*/
+class PolyMeshHandler {
+public:
+
+    enum {
+        BatchSize = 4096    //!< The max points or faces passed per call
+    };
+
+    virtual ~PolyMeshHandler()
+    {
+    }
+
+
+    //! Called once with the total number of steps.
+    virtual bool    beginRead(FOAM_UINT32 numSteps) = 0;
+
+    //! Called at the start of each step with the step's item count.
+    virtual bool    beginStep(FOAM_UINT32 total) = 0;
+
+    //! Called as cnt more items of the current step are completed.
+    virtual bool    stepIncr(FOAM_UINT32 cnt) = 0;
+
+    //! Called at the end of each step.
+    virtual bool    endStep() = 0;
+
+    //! Polled while parallel work runs. Returning true cancels the work and
+    //! the read. The default never aborts.
+    virtual bool    isAborted() {
+                        return false; }
+
+
+    //! Called before the first pushPoints().
+    virtual bool    beginPoints(FOAM_UINT32 numPts) = 0;
+
+    //! Receives points [first, first + cnt).
+    virtual bool    pushPoints(FOAM_UINT32 first, const FoamPoint *pts,
+                        FOAM_UINT32 cnt) = 0;
+
+    //! Called after the last pushPoints().
+    virtual bool    endPoints() = 0;
+
+
+    //! Receives all cell, face and point zones before beginFaces(). Only
+    //! called if the mesh has zones. The default ignores the zones.
+    virtual bool    pushZones(const FoamZone *zones, FOAM_UINT32 cnt) {
+                        (void)zones;
+                        (void)cnt;
+                        return true; }
+
+
+    //! Called before the first pushFaces().
+    virtual bool    beginFaces(FOAM_UINT32 numFaces) = 0;
+
+    //! Receives the next cnt faces. The faces are oriented so that an
+    //! interior face's normal points from the neighbor cell into the owner
+    //! cell and a boundary face's normal points into the owner cell.
+    virtual bool    pushFaces(const FoamFace *faces, FOAM_UINT32 cnt) = 0;
+
+    //! Called after the last pushFaces().
+    virtual bool    endFaces() = 0;
+};
+
+#endif // POLYMESHHANDLER_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,332 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef POLYMESHPRESCAN_H
+#define POLYMESHPRESCAN_H
+
+#include "FaceListFile.h"
+#include "FoamArchive.h"
+#include "FoamBuffer.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "LabelListFile.h"
+#include "PolyMeshHandler.h"
+#include "VectorFieldFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A fast structural check of the polyMesh files.
+
+    The headers of the four files must already be open. Each file is mapped
+    (or found in the archive) and its records are counted without being
+    decoded. The faces and points records are counted by searching for their
+    closing ')' with memchr(). A ')' in a comment is not counted. The owner
+    and neighbour labels are counted with a scan that decodes up to 8 digits
+    at a time and also tracks the largest label. The four files are scanned
+    concurrently.
+
+    The scan fails if any file's record count differs from its declared count,
+    if the closing ')' is missing or followed by anything but white space and
+    comments, if a label does not fit in 32 bits, if an owner or neighbour
+    label is not a valid cell, or if the owner and neighbour header notes
+    disagree with the actual counts. The cell count is the nCells note of
+    the owner file or, without it, one more than the largest label.
+
+    The scans are tasks of the current FoamTaskPool. They are skipped if the
+    current pool cancels them.
+*/
+class PolyMeshPrescan {
+public:
+
+    PolyMeshPrescan(VectorFieldFile &pointsFile, FaceListFile &facesFile,
+            LabelListFile &ownerFile, LabelListFile &neighborFile,
+            const FoamArchive *archive = 0) :
+        pointsFile_(pointsFile),
+        facesFile_(facesFile),
+        ownerFile_(ownerFile),
+        neighborFile_(neighborFile),
+        archive_(archive)
+    {
+    }
+
+    ~PolyMeshPrescan()
+    {
+    }
+
+
+    //! Runs the scan as a single progress step.
+    //! \return false if any check fails.
+    bool
+    run(PolyMeshHandler &handler)
+    {
+        const FOAM_UINT32 NumScans = 4;
+        bool ok[NumScans] = { false, false, false, false };
+        FOAM_UINT32 maxOwner = 0;
+        FOAM_UINT32 maxNbor = 0;
+        bool ret = handler.beginStep(NumScans);
+        if (ret) {
+            FoamCurrentPool current;
+            FoamTaskPool &pool = current.get();
+            FoamTaskPool::Group group;
+            pool.run(group, [&]() {
+                ok[0] = countRecords(pointsFile_.getBaseName().c_str(),
+                    pointsFile_.getNumPts()); });
+            pool.run(group, [&]() {
+                ok[1] = countRecords(facesFile_.getBaseName().c_str(),
+                    facesFile_.getNumFaces()); });
+            pool.run(group, [&]() {
+                ok[2] = scanLabels(ownerFile_.getBaseName().c_str(),
+                    ownerFile_.getNumLabels(), maxOwner); });
+            ok[3] = scanLabels(neighborFile_.getBaseName().c_str(),
+                neighborFile_.getNumLabels(), maxNbor);
+            ret = pool.wait(group) && ok[0] && ok[1] && ok[2] && ok[3] &&
+                handler.stepIncr(NumScans);
+        }
+        // A cell may own no face, so the neighbours bound the cells too
+        FOAM_UINT32 numCells;
+        if (!ownerFile_.getNoteVal("nCells", numCells)) {
+            numCells = std::max(maxOwner, maxNbor) + 1;
+        }
+        ret = ret && (0 != ownerFile_.getNumLabels()) &&
+            (maxOwner < numCells) && (maxNbor < numCells) &&
+            notesMatch(ownerFile_, numCells) &&
+            notesMatch(neighborFile_, numCells);
+        return handler.endStep() && ret;
+    }
+
+private:
+
+    //! Maps fileName and leaves data positioned after the "N (" that starts
+    //! the list. An archive member is used in place.
+    bool
+    mapData(const char *fileName, FoamMappedFile &file, FoamBuffer &data,
+        FOAM_UINT32 &cnt) const
+    {
+        FoamBuffer::StringStringMap hdrVals;
+        const char *begin = 0;
+        size_t size = 0;
+        bool ret = (0 != archive_) ? archive_->find(fileName, begin, size) :
+            file.open(fileName);
+        if (ret && (0 == archive_)) {
+            begin = file.begin();
+            size = file.size();
+        }
+        if (ret) {
+            data = FoamBuffer(begin, begin + size);
+            ret = data.readHeader(hdrVals) && data.readListBegin(cnt);
+        }
+        return ret;
+    }
+
+
+    //! \return true if the list in fileName has expected ")" terminated
+    //! records followed by a closing ")" and EOF.
+    bool
+    countRecords(const char *fileName, FOAM_UINT32 expected) const
+    {
+        FoamMappedFile file;
+        FoamBuffer data;
+        FOAM_UINT32 cnt;
+        bool ret = mapData(fileName, file, data, cnt) && (expected == cnt);
+        if (ret) {
+            // The expected+1 ")" closes the list. The next "/" is tracked
+            // to skip any comment before the next ")".
+            const char *pos = data.pos();
+            const char *end = data.end();
+            const char *slash = findChar(pos, end, '/');
+            FOAM_UINT64 numParens = 0;
+            const FOAM_UINT64 numWanted =
+                static_cast<FOAM_UINT64>(expected) + 1;
+            while (ret && (numParens < numWanted) && (pos < end)) {
+                const char *paren = findChar(pos, end, ')');
+                if (slash < paren) {
+                    FoamBuffer comment(slash, end);
+                    ret = comment.wspaceCommentsSkip();
+                    pos = (slash == comment.pos()) ? slash + 1 :
+                        comment.pos();
+                    slash = findChar(pos, end, '/');
+                }
+                else if (paren < end) {
+                    pos = paren + 1;
+                    ++numParens;
+                }
+                else {
+                    pos = end;
+                }
+            }
+            ret = ret && (numWanted == numParens) &&
+                FoamBuffer(pos, end).wspaceCommentsSkipToEnd();
+        }
+        return ret;
+    }
+
+
+    //! \return true if the list in fileName has expected labels followed by
+    //! a closing ")" and EOF. The largest label is returned in maxLbl.
+    bool
+    scanLabels(const char *fileName, FOAM_UINT32 expected,
+        FOAM_UINT32 &maxLbl) const
+    {
+        FoamMappedFile file;
+        FoamBuffer data;
+        FOAM_UINT32 cnt;
+        bool ret = mapData(fileName, file, data, cnt) && (expected == cnt);
+        if (ret) {
+            const unsigned char *p =
+                reinterpret_cast<const unsigned char*>(data.pos());
+            const unsigned char *end =
+                reinterpret_cast<const unsigned char*>(data.end());
+            FOAM_UINT64 numLbls = 0;
+            FOAM_UINT64 maxVal = 0;
+            while (p < end) {
+                if (static_cast<unsigned int>(*p - '0') < 10) {
+                    const FOAM_UINT64 val = readLabel(p, end);
+                    maxVal = (val > maxVal) ? val : maxVal;
+                    ++numLbls;
+                }
+                else if (std::isspace(*p)) {
+                    ++p;
+                }
+                else if ('/' == *p) {
+                    FoamBuffer comment(reinterpret_cast<const char*>(p),
+                        data.end());
+                    if (!comment.wspaceCommentsSkip() ||
+                            (comment.pos() == reinterpret_cast<
+                                const char*>(p))) {
+                        break;
+                    }
+                    p = reinterpret_cast<const unsigned char*>(comment.pos());
+                }
+                else {
+                    // should be the closing paren
+                    break;
+                }
+            }
+            maxLbl = static_cast<FOAM_UINT32>(maxVal);
+            ret = (numLbls == expected) && (maxVal < FOAM_UINT32_MAX) &&
+                (p < end) && (')' == *p) &&
+                FoamBuffer(reinterpret_cast<const char*>(p + 1),
+                    data.end()).wspaceCommentsSkipToEnd();
+        }
+        return ret;
+    }
+
+
+    //! \return The first ch in [pos, end) or end if there is none.
+    static const char *
+    findChar(const char *pos, const char *end, char ch)
+    {
+        const void *found = std::memchr(pos, ch, end - pos);
+        return (0 == found) ? end : static_cast<const char*>(found);
+    }
+
+
+    /*! Decodes the digits at p and moves p past them. A run of fewer than 8
+        digits followed by at least one more byte is decoded from one 64 bit
+        word. Each byte is classified as a digit with a few word wide
+        operations and the digits are combined pairwise in 3 multiplies.
+        Longer runs and the digits at the end of the data are decoded a byte
+        at a time.
+        \return The value or a value above FOAM_UINT32_MAX if it overflows.
+    */
+    static FOAM_UINT64
+    readLabel(const unsigned char *&p, const unsigned char *end)
+    {
+        const FOAM_UINT64 Ones = 0x0101010101010101ULL;
+        FOAM_UINT64 val = 0;
+        if (end - p >= 8) {
+            // The first byte is the lowest on every host
+            FOAM_UINT64 word = 0;
+            for (int ii = 7; ii >= 0; --ii) {
+                word = (word << 8) | p[ii];
+            }
+            // A byte is a digit if its low bits are 0 to 9 after the xor
+            const FOAM_UINT64 low = word ^ (Ones * '0');
+            const FOAM_UINT64 nonDigit = (((low & (Ones * 0x7F)) +
+                (Ones * 0x76)) | low) & (Ones * 0x80);
+            if (0 != nonDigit) {
+                // The number of bytes below the first non digit
+                const FOAM_UINT64 below = (nonDigit & (~nonDigit + 1)) - 1;
+                const unsigned int cnt = static_cast<unsigned int>(
+                    ((below & Ones) * Ones) >> 56) - 1;
+                // Drop the bytes past the digits. The first digit is the
+                // most significant.
+                val = (word - (Ones * '0')) << (8 * (8 - cnt));
+                val = ((val * 10) + (val >> 8)) & 0x00FF00FF00FF00FFULL;
+                val = ((val * 100) + (val >> 16)) & 0x0000FFFF0000FFFFULL;
+                val = ((val * 10000) + (val >> 32)) & 0xFFFFFFFFULL;
+                p += cnt;
+                return val;
+            }
+        }
+        unsigned int digit;
+        while ((p < end) && ((digit = *p - '0') < 10)) {
+            // Stop growing once it overflows
+            if (val <= FOAM_UINT32_MAX) {
+                val = (val * 10) + digit;
+            }
+            ++p;
+        }
+        return val;
+    }
+
+
+    //! \return true if the counts in file's header note (if any) match the
+    //! counts found in the files.
+    bool
+    notesMatch(FoamFile &file, FOAM_UINT32 numCells) const
+    {
+        FOAM_UINT32 val;
+        return (!file.getNoteVal("nPoints", val) ||
+                (val == pointsFile_.getNumPts())) &&
+            (!file.getNoteVal("nCells", val) || (val == numCells)) &&
+            (!file.getNoteVal("nFaces", val) ||
+                (val == facesFile_.getNumFaces())) &&
+            (!file.getNoteVal("nInternalFaces", val) ||
+                (val == neighborFile_.getNumLabels()));
+    }
+
+private:
+    PolyMeshPrescan(const PolyMeshPrescan&);
+    const PolyMeshPrescan& operator=(const PolyMeshPrescan&);
+
+private:
+    VectorFieldFile &   pointsFile_;
+    FaceListFile &      facesFile_;
+    LabelListFile &     ownerFile_;
+    LabelListFile &     neighborFile_;
+    const FoamArchive * archive_;   //!< The archive to read from or 0
+};
+
+#endif // POLYMESHPRESCAN_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
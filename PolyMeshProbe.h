@@ -0,0 +1,289 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef POLYMESHPROBE_H
+#define POLYMESHPROBE_H
+
+#include "BoundaryFile.h"
+#include "CollatedFile.h"
+#include "FoamArchive.h"
+#include "FoamFile.h"
+#include "LabelListFile.h"
+#include "VectorFieldFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! The polyMesh metadata returned by probePolyMesh().
+*/
+struct PolyMeshInfo {
+
+    PolyMeshInfo() :
+        numPts(0),
+        numFaces(0),
+        numInternalFaces(0),
+        numCells(0),
+        format(),
+        facesClass(),
+        arch(),
+        labelBits(32),
+        scalarBits(64),
+        compression("none"),
+        storage("files"),
+        numRanks(0),
+        note(),
+        location(),
+        patches()
+    {
+    }
+
+    FOAM_UINT32                 numPts;             //!< The points count
+    FOAM_UINT32                 numFaces;           //!< The faces count
+    FOAM_UINT32                 numInternalFaces;   //!< The neighbour count
+    FOAM_UINT32                 numCells;           //!< The nCells note
+                                                    //!< of owner or 0
+    std::string                 format;             //!< ascii or binary
+    std::string                 facesClass;         //!< faceList or
+                                                    //!< faceCompactList
+    std::string                 arch;               //!< The raw arch string
+    FOAM_UINT32                 labelBits;          //!< From arch. Def 32
+    FOAM_UINT32                 scalarBits;         //!< From arch. Def 64
+    std::string                 compression;        //!< none or gzip
+    std::string                 storage;            //!< files, collated
+                                                    //!< or archive
+    FOAM_UINT32                 numRanks;           //!< The collated ranks
+    std::string                 note;               //!< The owner note
+    std::string                 location;           //!< The faces location
+    BoundaryFile::PatchArray1   patches;            //!< The boundary patches
+};
+
+
+//---------------------------------------------------------------------------
+
+/*! Reads the header and face count of a faceList or faceCompactList file.
+
+    Binary meshes store their faces as a faceCompactList. Its first list
+    holds the offset of each face's points plus one end offset, so it has
+    one more entry than there are faces. The list count is ascii in both
+    formats.
+
+    A collated (decomposedBlockData) file is accepted without a count.
+*/
+class FaceHeaderFile : public FoamFile {
+public:
+
+    FaceHeaderFile(const char *baseName) :
+        FoamFile(baseName),
+        numFaces_(0),
+        isCollated_(false)
+    {
+    }
+
+    virtual ~FaceHeaderFile()
+    {
+    }
+
+
+    //! \return The number of faces in this file.
+    inline FOAM_UINT32  getNumFaces() const {
+                            return numFaces_; }
+
+    //! \return true if this is a collated file.
+    inline bool         isCollated() const {
+                            return isCollated_; }
+
+private:
+    virtual bool
+    afterReadHeader()
+    {
+        FOAM_UINT32 cnt = 0;
+        bool ret = false;
+        isCollated_ = headerValIs("class", "decomposedBlockData");
+        if (isCollated_) {
+            numFaces_ = 0;
+            ret = true;
+        }
+        else if (headerValIs("class", "faceList")) {
+            ret = readInt(cnt);
+            numFaces_ = cnt;
+        }
+        else if (headerValIs("class", "faceCompactList")) {
+            ret = readInt(cnt) && (0 < cnt);
+            numFaces_ = ret ? cnt - 1 : 0;
+        }
+        return ret;
+    }
+
+private:
+    FOAM_UINT32  numFaces_;     //!< The number of faces in the file
+    bool         isCollated_;   //!< true if the file is collated
+};
+
+
+//---------------------------------------------------------------------------
+
+//! Joins dirName and fileName. An empty dirName is the cwd.
+inline static std::string
+polyMeshPath(const char *dirName, const char *fileName)
+{
+    std::string path = (0 == dirName) ? std::string() : std::string(dirName);
+    if (!path.empty() && ('/' != path[path.size() - 1]) &&
+            ('\\' != path[path.size() - 1])) {
+        path += '/';
+    }
+    return path + fileName;
+}
+
+
+//! Removes all double quotes from str.
+inline static void
+unquote(std::string &str)
+{
+    str.erase(std::remove(str.begin(), str.end(), '"'), str.end());
+}
+
+
+//! Parses a "LSB;label=32;scalar=64" arch string.
+inline static void
+parseArch(PolyMeshInfo &info)
+{
+    std::string::size_type pos = info.arch.find("label=");
+    if (std::string::npos != pos) {
+        info.labelBits = static_cast<FOAM_UINT32>(
+            std::strtoul(info.arch.c_str() + pos + 6, 0, 10));
+    }
+    pos = info.arch.find("scalar=");
+    if (std::string::npos != pos) {
+        info.scalarBits = static_cast<FOAM_UINT32>(
+            std::strtoul(info.arch.c_str() + pos + 7, 0, 10));
+    }
+}
+
+
+//! \return true if fileName can be opened for reading.
+inline static bool
+polyMeshFileExists(const std::string &fileName)
+{
+    FILE *fp = std::fopen(fileName.c_str(), "rb");
+    if (0 != fp) {
+        std::fclose(fp);
+    }
+    return 0 != fp;
+}
+
+
+/*! Loads the polyMesh metadata in dirName, or in the mesh directory of
+    archive if it is not 0, into info.
+
+    Only the points, faces, owner and neighbour headers and list counts are
+    read. The boundary file is small and is read in full to get the patches.
+    The run time does not depend on the mesh size.
+
+    The faces may be a faceList (ascii) or a faceCompactList (usually
+    binary). info.facesClass tells which.
+
+    If the faces file is collated, info.storage is "collated" and only the
+    format, arch and number of ranks are set. The merged counts and the
+    patches need the blocks of every rank and are left 0 and empty. An
+    archive cannot hold a collated mesh. If the mesh is read from archive,
+    info.storage is "archive" and info.compression tells whether it was
+    gzip compressed.
+
+    If the files are gzip compressed one by one, only info.compression is
+    set and false is returned. info.numCells is only set if the owner header
+    has an nCells note. Otherwise it is 0, as counting the cells needs every
+    owner and neighbour label.
+
+    \return false if the headers could not be read or are compressed.
+*/
+inline bool
+probePolyMesh(const char *dirName, PolyMeshInfo &info,
+    const FoamArchive *archive = 0)
+{
+    info = PolyMeshInfo();
+    // The archive files are named relative to its mesh directory
+    const char *dir = (0 == archive) ? dirName : 0;
+    const std::string facesName = polyMeshPath(dir, "faces");
+    if ((0 == archive) && !polyMeshFileExists(facesName) &&
+            polyMeshFileExists(facesName + ".gz")) {
+        // The headers cannot be read without inflating the files
+        info.compression = "gzip";
+        return false;
+    }
+    FaceHeaderFile facesFile(facesName.c_str());
+    facesFile.setArchive(archive);
+    bool ret = facesFile.open();
+    if (ret) {
+        facesFile.getHeaderVal("format", info.format, "ascii");
+        facesFile.getHeaderVal("class", info.facesClass, "");
+        facesFile.getHeaderVal("arch", info.arch, "");
+        facesFile.getHeaderVal("location", info.location, "");
+        unquote(info.arch);
+        unquote(info.location);
+        parseArch(info);
+    }
+    if (ret && facesFile.isCollated()) {
+        CollatedFile collatedFile(facesName.c_str());
+        ret = (0 == archive) && collatedFile.open();
+        info.storage = "collated";
+        info.numRanks = ret ? collatedFile.getNumBlocks() : 0;
+        return ret;
+    }
+    VectorFieldFile pointsFile(polyMeshPath(dir, "points").c_str());
+    LabelListFile ownerFile(polyMeshPath(dir, "owner").c_str());
+    LabelListFile neighborFile(polyMeshPath(dir, "neighbour").c_str());
+    BoundaryFile boundaryFile(polyMeshPath(dir, "boundary").c_str());
+    pointsFile.setArchive(archive);
+    ownerFile.setArchive(archive);
+    neighborFile.setArchive(archive);
+    boundaryFile.setArchive(archive);
+    ret = ret && pointsFile.open() && ownerFile.open() &&
+        neighborFile.open() && boundaryFile.open() &&
+        boundaryFile.readPatches(info.patches);
+    if (ret) {
+        info.numPts = pointsFile.getNumPts();
+        info.numFaces = facesFile.getNumFaces();
+        info.numInternalFaces = neighborFile.getNumLabels();
+        ownerFile.getNoteVal("nCells", info.numCells);
+        ownerFile.getHeaderVal("note", info.note, "");
+        unquote(info.note);
+    }
+    if (0 != archive) {
+        info.storage = "archive";
+        info.compression = archive->isCompressed() ? "gzip" : "none";
+    }
+    return ret;
+}
+
+#endif // POLYMESHPROBE_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,748 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef POLYMESHREADER_H
+#define POLYMESHREADER_H
+
+#include "CellFaceCsr.h"
+#include "CollatedPolyMesh.h"
+#include "FaceListFile.h"
+#include "FoamArchive.h"
+#include "FoamArena.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "ImportOptions.h"
+#include "LabelListFile.h"
+#include "MeshQuality.h"
+#include "PolyMeshHandler.h"
+#include "PointCompactor.h"
+#include "PolyMeshPrescan.h"
+#include "VectorFieldFile.h"
+#include "ZoneListFile.h"
+
+#include <algorithm> // for swap() < C++11
+#include <cassert>
+#include <vector>
+//#include <utility> // for swap() >= C++11
+
+
+// Swaps face indices so the face normal is reversed
+inline static void
+reverseFace(FoamFace &face)
+{
+    if (4 == face.vertCnt) {
+        std::swap(face.index[1], face.index[3]);
+    }
+    else if (3 == face.vertCnt) {
+        std::swap(face.index[1], face.index[2]);
+    }
+    else {
+        // Could not reverse an unsupported face type
+        assert(false);
+    }
+}
+
+
+// Orients an OpenFOAM face for PolyMeshHandler::pushFaces()
+inline static void
+orientFace(FoamFace &face)
+{
+    // The OpenFOAM spec requires:
+    // * An internal-face's normal points from the cell with the lower index
+    //   towards the cell with the higher index.
+    // * A boundary-face's normal points outside the owner cell.
+    //
+    // The handler (and GRDP) spec requires:
+    // * An internal-face's normal points from the neighbor cell towards the
+    //   owner cell.
+    // * A boundary-face's normal points into the owner cell.
+    //
+    //               --- InteriorFaceNormal --->
+    //  OpenFOAM  Cell[LowNdx]        Cell[HighNdx]
+    //  GRDP API  Cell[NeighborNdx]   Cell[OwnerNdx]
+    //
+    //               --- BndryFaceNormal --->
+    //  OpenFOAM  Cell[OwnerNdx]   (GridExterior)
+    //  GRDP API  (GridExterior)   Cell[OwnerNdx]
+    if (FOAM_FACETYPE_INTERIOR == face.type) {
+        if (face.owner < face.neighbor) {
+            // Since the OF owner index is < OF neighbor index, the face normal
+            // is wrong direction for PW. We could reverse the face vertices,
+            // but swapping the cell indices is faster.
+            std::swap(face.owner, face.neighbor);
+        }
+    }
+    else {
+        // OF boundary faces always have the wrong face normal for PW. Need to
+        // reverse the face so the normal points INTO the owner cell.
+        reverseFace(face);
+    }
+}
+
+
+// Orients cnt faces that all have VertCnt vertices. Same as orientFace() but
+// a boundary face is reversed without checking its vertex count.
+template<FOAM_UINT32 VertCnt>
+inline static void
+orientFixedFaces(FoamFace *faces, FOAM_UINT32 cnt)
+{
+    for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+        FoamFace &face = faces[ii];
+        if (FOAM_FACETYPE_INTERIOR == face.type) {
+            if (face.owner < face.neighbor) {
+                std::swap(face.owner, face.neighbor);
+            }
+        }
+        else {
+            std::swap(face.index[1], face.index[VertCnt - 1]);
+        }
+    }
+}
+
+
+// Orients cnt faces. If uniform is true, all faces have vertCnt vertices.
+inline static void
+orientFaces(FoamFace *faces, FOAM_UINT32 cnt, FOAM_UINT32 vertCnt,
+    bool uniform)
+{
+    if (uniform && (4 == vertCnt)) {
+        orientFixedFaces<4>(faces, cnt);
+    }
+    else if (uniform && (3 == vertCnt)) {
+        orientFixedFaces<3>(faces, cnt);
+    }
+    else {
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            orientFace(faces[ii]);
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Reads the polyMesh in the cwd and passes it to a PolyMeshHandler.
+
+    If the archive option is set, the polyMesh files are read from that tar
+    archive instead. Collated meshes cannot be read from an archive.
+
+    If the arena option is set, one arena sized from the header counts holds
+    the face batch, preloaded labels, loaded faces, cell to face adjacency
+    and point numbering.
+
+    The parallel stages run on the given FoamTaskPool. Without one, they
+    run serially on the calling thread. The handler's isAborted() is polled
+    while they run.
+
+    This class and the file classes it uses do not depend on the PluginSDK.
+    Each instance is independent, so separate threads may read separate
+    meshes concurrently.
+*/
+class PolyMeshReader {
+
+    typedef FoamFaceArray1      FaceArray1;
+    typedef FoamLabelArray1     UInt32Array1;
+
+public:
+
+    PolyMeshReader(const ImportOptions &options = ImportOptions(),
+            FoamTaskPool *pool = 0) :
+        options_(options),
+        pool_(pool),
+        archive_(),
+        arena_(),
+        facesFile_("faces"),
+        ownerFile_("owner"),
+        neighborFile_("neighbour"),
+        pointsFile_("points"),
+        cellZonesFile_("cellZones", FOAM_ZONETYPE_CELL),
+        faceZonesFile_("faceZones", FOAM_ZONETYPE_FACE),
+        pointZonesFile_("pointZones", FOAM_ZONETYPE_POINT),
+        batch_(FoamArenaAllocator<FoamFace>(&arena_)),
+        batchCnt_(0),
+        preloaded_(false),
+        owners_(FoamArenaAllocator<FOAM_UINT32>(&arena_)),
+        neighbors_(FoamArenaAllocator<FOAM_UINT32>(&arena_)),
+        faces_(FoamArenaAllocator<FoamFace>(&arena_))
+    {
+    }
+
+    ~PolyMeshReader()
+    {
+    }
+
+
+    //! Reads the mesh and passes its points and faces to handler.
+    bool
+    read(PolyMeshHandler &handler)
+    {
+        FoamTaskScope scope(pool_, [&handler]() {
+            return !handler.isAborted(); });
+        bool ret;
+        if (options_.qualityReport.empty()) {
+            ret = readMesh(handler);
+        }
+        else {
+            // Compute the quality metrics as the mesh passes through
+            MeshQuality quality(handler);
+            ret = readMesh(quality) &&
+                quality.writeReport(options_.qualityReport.c_str());
+        }
+        return ret && (options_.memoryReport.empty() ||
+            arena_.writeReport(options_.memoryReport.c_str()));
+    }
+
+
+    //! \return The arena holding the staging buffers.
+    inline const FoamArena &
+                    getArena() const {
+                        return arena_; }
+
+private:
+
+    bool
+    readMesh(PolyMeshHandler &handler)
+    {
+        // Open files and do some sanity checks before doing heavy lifting.
+        // All faces have owners (numOwners == numFaces).
+        // Only internal faces have neighbors (numNeighbors < numFaces)
+        // The optional prescan rejects bad files before any grid model memory
+        // is allocated.
+        const bool archiveOk = options_.archive.empty() || openArchive();
+        const bool isFaceList = archiveOk && facesFile_.open();
+        const bool filesOk = isFaceList && pointsFile_.open() &&
+            ownerFile_.open() && neighborFile_.open() &&
+            (ownerFile_.getNumLabels() == facesFile_.getNumFaces()) &&
+            (neighborFile_.getNumLabels() < facesFile_.getNumFaces());
+        const bool doPrescan = isFaceList && options_.prescan;
+        const bool hasZones = isFaceList && (cellZonesFile_.exists() ||
+            faceZonesFile_.exists() || pointZonesFile_.exists());
+        // Grouping the faces by cell needs all faces and labels in memory
+        // before the points are read. Dropping unused points needs the used
+        // points marked before the points are read. They are marked as the
+        // faces are loaded or by a first pass over the faces file.
+        const bool canLoad = filesOk && canPreload();
+        const bool cellOrder = canLoad && options_.cellOrder;
+        const bool compact = filesOk && options_.compactPoints;
+        const bool doLoad = cellOrder;
+        const FOAM_UINT32 NumMajorSteps = 4 + (doPrescan ? 1 : 0) +
+            (hasZones ? 1 : 0) + ((doLoad || compact) ? 1 : 0);
+        if (filesOk && options_.arena) {
+            // The buffers use the heap if the reservation fails
+            reserveArena(cellOrder, compact);
+        }
+        PointCompactor compactor(handler, &arena_);
+        PolyMeshHandler &next = compact ? compactor : handler;
+        bool ret = handler.beginRead(NumMajorSteps);
+        if (ret && isFaceList && !doLoad) {
+            ret = filesOk && (!doPrescan || prescan(handler)) &&
+                (!compact || markUsedPoints(handler, compactor)) &&
+                pointsFile_.read(next) && (!hasZones || readZones(next)) &&
+                readCells(next);
+        }
+        else if (ret && isFaceList) {
+            ret = (!doPrescan || prescan(handler)) &&
+                loadFaces(handler, compact ? &compactor : 0) &&
+                pointsFile_.read(next) && (!hasZones || readZones(next)) &&
+                pushLoadedFaces(next, cellOrder);
+        }
+        else if (ret) {
+            // faces is not a faceList. Try the collated format.
+            ret = options_.archive.empty() && readCollated(handler);
+        }
+        return ret;
+    }
+
+
+    //! Indexes the archive and reads all files from it.
+    bool
+    openArchive()
+    {
+        const bool ret = archive_.open(options_.archive.c_str(),
+            options_.archiveMeshDir.c_str());
+        if (ret) {
+            facesFile_.setArchive(&archive_);
+            ownerFile_.setArchive(&archive_);
+            neighborFile_.setArchive(&archive_);
+            pointsFile_.setArchive(&archive_);
+            cellZonesFile_.setArchive(&archive_);
+            faceZonesFile_.setArchive(&archive_);
+            pointZonesFile_.setArchive(&archive_);
+        }
+        return ret;
+    }
+
+
+    //! Reserves the arena for all buffers that the read will use. The
+    //! sizes come from the header counts. Nothing has been read yet.
+    bool
+    reserveArena(bool cellOrder, bool compact)
+    {
+        const FOAM_UINT64 numFaces = facesFile_.getNumFaces();
+        const FOAM_UINT64 numNbors = neighborFile_.getNumLabels();
+        FOAM_UINT64 numBytes = FoamArena::bytesFor<FoamFace>(
+            PolyMeshHandler::BatchSize);
+        if (canPreload()) {
+            numBytes += FoamArena::bytesFor<FOAM_UINT32>(numFaces) +
+                FoamArena::bytesFor<FOAM_UINT32>(numNbors);
+        }
+        if (cellOrder) {
+            // Every cell owns at least one face. So, there are at most
+            // numFaces cells.
+            numBytes += FoamArena::bytesFor<FoamFace>(numFaces) +
+                FoamArena::bytesFor<FOAM_UINT32>(numFaces + 1) +
+                FoamArena::bytesFor<FOAM_UINT32>(numFaces + numNbors);
+        }
+        if (compact) {
+            // One used point count per 64 points
+            numBytes += FoamArena::bytesFor<FOAM_UINT32>(
+                (pointsFile_.getNumPts() + 63) / 64);
+        }
+        return arena_.reserve(numBytes, options_.hugePages);
+    }
+
+
+    bool prescan(PolyMeshHandler &handler)
+    {
+        PolyMeshPrescan scan(pointsFile_, facesFile_, ownerFile_,
+            neighborFile_, archive_.isOpen() ? &archive_ : 0);
+        return scan.run(handler);
+    }
+
+
+    //! Reads the zone files that exist and passes all zones to handler.
+    bool readZones(PolyMeshHandler &handler)
+    {
+        ZoneListFile *files[] = {
+            &cellZonesFile_, &faceZonesFile_, &pointZonesFile_ };
+        const FOAM_UINT32 NumFiles = 3;
+        FoamZoneArray1 zones;
+        bool ret = handler.beginStep(NumFiles);
+        for (FOAM_UINT32 ii = 0; ii < NumFiles && ret; ++ii) {
+            ret = (!files[ii]->exists() || files[ii]->read(zones)) &&
+                handler.stepIncr(1);
+        }
+        // The labels are sorted, so only the last one needs a range check.
+        const FOAM_UINT32 numCells = ret ? getCellBound() : 0;
+        const FOAM_UINT32 numFaces = facesFile_.getNumFaces();
+        const FOAM_UINT32 numPts = pointsFile_.getNumPts();
+        for (size_t ii = 0; ii < zones.size() && ret; ++ii) {
+            const FoamZone &zone = zones[ii];
+            ret = zone.labels.empty() ||
+                ((FOAM_ZONETYPE_CELL == zone.type) &&
+                    (zone.labels.back() < numCells)) ||
+                ((FOAM_ZONETYPE_FACE == zone.type) &&
+                    (zone.labels.back() < numFaces)) ||
+                ((FOAM_ZONETYPE_POINT == zone.type) &&
+                    (zone.labels.back() < numPts));
+        }
+        ret = ret && (zones.empty() || handler.pushZones(&zones[0],
+            static_cast<FOAM_UINT32>(zones.size())));
+        return handler.endStep() && ret;
+    }
+
+
+    //! \return The cell count if the labels are preloaded or the owner
+    //! header note has nCells, else the face count. Every cell has at least
+    //! four faces, so no valid cell label can reach the face count.
+    FOAM_UINT32
+    getCellBound()
+    {
+        FOAM_UINT32 numCells = 0;
+        if (preloaded_) {
+            for (size_t ii = 0; ii < owners_.size(); ++ii) {
+                numCells = std::max(numCells, owners_[ii] + 1);
+            }
+            for (size_t ii = 0; ii < neighbors_.size(); ++ii) {
+                numCells = std::max(numCells, neighbors_[ii] + 1);
+            }
+        }
+        else if (!ownerFile_.getNoteVal("nCells", numCells)) {
+            numCells = facesFile_.getNumFaces();
+        }
+        return numCells;
+    }
+
+
+    //! \return true if the owner and neighbour labels fit in the preload
+    //! memory budget.
+    bool
+    canPreload() const
+    {
+        const FOAM_UINT64 numBytes = sizeof(FOAM_UINT32) *
+            (static_cast<FOAM_UINT64>(ownerFile_.getNumLabels()) +
+                neighborFile_.getNumLabels());
+        return numBytes <= (static_cast<FOAM_UINT64>(options_.preloadMB) << 20);
+    }
+
+
+    //! Reads all owner and neighbour labels into memory. Each file is read
+    //! start to end in one sequential pass and closed, so the faces file is
+    //! then the only file being read.
+    bool
+    preloadLabels()
+    {
+        preloaded_ = ownerFile_.readAllLabels(owners_) &&
+            neighborFile_.readAllLabels(neighbors_);
+        ownerFile_.close();
+        neighborFile_.close();
+        return preloaded_;
+    }
+
+
+    //! Gets the owner of face ndx from the preloaded labels or the file.
+    inline bool
+    readOwner(FOAM_UINT32 ndx, FOAM_UINT32 &owner)
+    {
+        if (!preloaded_) {
+            return ownerFile_.readNextLabel(owner);
+        }
+        owner = owners_[ndx];
+        return true;
+    }
+
+
+    //! Gets the neighbor of face ndx from the preloaded labels or the file.
+    inline bool
+    readNeighbor(FOAM_UINT32 ndx, FOAM_UINT32 &neighbor)
+    {
+        if (!preloaded_) {
+            return neighborFile_.readNextLabel(neighbor);
+        }
+        neighbor = neighbors_[ndx];
+        return true;
+    }
+
+
+    bool readCells(PolyMeshHandler &handler)
+    {
+        const FOAM_UINT32 numFaces = facesFile_.getNumFaces();
+        // Reading the faces, owner and neighbour files in lockstep defeats
+        // readahead on disks and network file systems. If the labels fit in
+        // the memory budget, read them first so the faces are read alone.
+        const bool preload = canPreload();
+        bool ret = handler.beginStep(numFaces) &&
+            (!preload || preloadLabels());
+        if (ret && handler.beginFaces(numFaces)) {
+            // Pure hex and pure tet meshes use the fixed-arity kernels
+            const FOAM_UINT32 vertCnt = facesFile_.sampleVertCnt();
+            const FOAM_UINT32 batchSize = PolyMeshHandler::BatchSize;
+            batch_.resize(batchSize);
+            for (FOAM_UINT32 ii = 0; ii < numFaces && ret; ii += batchSize) {
+                const FOAM_UINT32 cnt = std::min(numFaces - ii, batchSize);
+                bool uniform;
+                ret = readFaceBatch(&batch_[0], cnt, vertCnt, uniform) &&
+                    readBatchCells(ii, &batch_[0], cnt);
+                if (ret) {
+                    orientFaces(&batch_[0], cnt, vertCnt, uniform);
+                    // Stitch the faces into cells
+                    batchCnt_ = cnt;
+                    ret = flushFaces(handler);
+                }
+            }
+            // There should be one ) remaining and then EOF. A preloaded file
+            // was already checked.
+            ret = ret && (preload || (neighborFile_.wspaceSkipToChar(')') &&
+                neighborFile_.wspaceCommentsSkip() &&
+                neighborFile_.wspaceSkipToEOF()));
+            ret = ret && (preload || (ownerFile_.wspaceSkipToChar(')') &&
+                ownerFile_.wspaceCommentsSkip() &&
+                ownerFile_.wspaceSkipToEOF()));
+            ret = ret && handler.endFaces();
+        }
+        else {
+            ret = false;
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    //! Preloads the labels and reads all faces into memory as one step.
+    //! If compactor is not 0, the points used by the faces are marked.
+    bool loadFaces(PolyMeshHandler &handler, PointCompactor *compactor)
+    {
+        const FOAM_UINT32 numFaces = facesFile_.getNumFaces();
+        bool ret = handler.beginStep(numFaces) && preloadLabels();
+        if (ret) {
+            const FOAM_UINT32 vertCnt = facesFile_.sampleVertCnt();
+            const FOAM_UINT32 batchSize = PolyMeshHandler::BatchSize;
+            faces_.resize(numFaces);
+            if (0 != compactor) {
+                compactor->beginMark(pointsFile_.getNumPts());
+            }
+            for (FOAM_UINT32 ii = 0; ii < numFaces && ret; ii += batchSize) {
+                const FOAM_UINT32 cnt = std::min(numFaces - ii, batchSize);
+                bool uniform;
+                ret = readFaceBatch(&faces_[ii], cnt, vertCnt, uniform) &&
+                    ((0 == compactor) ||
+                        compactor->markFaces(&faces_[ii], cnt)) &&
+                    handler.stepIncr(cnt);
+            }
+            ret = ret && ((0 == compactor) || compactor->endMark());
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    //! Reads all faces once as one step to mark the points they use. Only
+    //! the current batch is kept. The faces file is then reopened for
+    //! readCells().
+    bool markUsedPoints(PolyMeshHandler &handler, PointCompactor &compactor)
+    {
+        const FOAM_UINT32 numFaces = facesFile_.getNumFaces();
+        bool ret = handler.beginStep(numFaces);
+        if (ret) {
+            const FOAM_UINT32 vertCnt = facesFile_.sampleVertCnt();
+            const FOAM_UINT32 batchSize = PolyMeshHandler::BatchSize;
+            batch_.resize(batchSize);
+            compactor.beginMark(pointsFile_.getNumPts());
+            for (FOAM_UINT32 ii = 0; ii < numFaces && ret; ii += batchSize) {
+                const FOAM_UINT32 cnt = std::min(numFaces - ii, batchSize);
+                bool uniform;
+                ret = readFaceBatch(&batch_[0], cnt, vertCnt, uniform) &&
+                    compactor.markFaces(&batch_[0], cnt) &&
+                    handler.stepIncr(cnt);
+            }
+            ret = ret && compactor.endMark() && facesFile_.open();
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    /*! Pushes the faces read by loadFaces().
+
+        If grouped is true, the cell to face adjacency is built and the faces
+        of each cell are pushed together in cell order. A face is pushed with
+        the first of its cells, so each face is still pushed once. This lets
+        the assembler stitch each cell from faces that arrive together.
+    */
+    bool pushLoadedFaces(PolyMeshHandler &handler, bool grouped)
+    {
+        const FOAM_UINT32 numFaces = facesFile_.getNumFaces();
+        const FOAM_UINT32 numNbors = neighborFile_.getNumLabels();
+        CellFaceCsr csr(&arena_);
+        bool ret = handler.beginStep(numFaces) &&
+            (!grouped || csr.build(owners_, neighbors_)) &&
+            handler.beginFaces(numFaces);
+        if (ret && grouped) {
+            batch_.resize(PolyMeshHandler::BatchSize);
+            const FOAM_UINT32 numCells = csr.getNumCells();
+            for (FOAM_UINT32 cc = 0; cc < numCells && ret; ++cc) {
+                const FOAM_UINT32 end = csr.getEnd(cc);
+                for (FOAM_UINT32 kk = csr.getBegin(cc); kk < end && ret; ++kk) {
+                    const FOAM_UINT32 ff = csr.getFace(kk);
+                    // Skip a face already pushed with its other cell
+                    ret = ((ff < numNbors) &&
+                            (cc != std::min(owners_[ff], neighbors_[ff]))) ||
+                        pushLoadedFace(handler, ff, numNbors);
+                }
+            }
+        }
+        else if (ret) {
+            batch_.resize(PolyMeshHandler::BatchSize);
+            for (FOAM_UINT32 ff = 0; ff < numFaces && ret; ++ff) {
+                ret = pushLoadedFace(handler, ff, numNbors);
+            }
+        }
+        // Stitch all the faces into cells
+        ret = ret && flushFaces(handler) && handler.endFaces();
+        FaceArray1(faces_.get_allocator()).swap(faces_);
+        return handler.endStep() && ret;
+    }
+
+
+    //! Adds the cells of loaded face ff and pushes it.
+    inline bool
+    pushLoadedFace(PolyMeshHandler &handler, FOAM_UINT32 ff,
+        FOAM_UINT32 numNbors)
+    {
+        FoamFace data = faces_[ff];
+        data.id = ff;
+        data.owner = owners_[ff];
+        if (ff < numNbors) {
+            data.type = FOAM_FACETYPE_INTERIOR;
+            data.neighbor = neighbors_[ff];
+        }
+        else {
+            data.type = FOAM_FACETYPE_BOUNDARY;
+            data.neighbor = FOAM_UINT32_MAX;
+        }
+        orientFace(data);
+        return pushFace(handler, data);
+    }
+
+
+    //! Reads the vertices of the next cnt faces. See
+    //! FaceListFile::readFaces().
+    bool
+    readFaceBatch(FoamFace *faces, FOAM_UINT32 cnt, FOAM_UINT32 vertCnt,
+        bool &uniform)
+    {
+        bool ret = facesFile_.readFaces(faces, cnt, vertCnt, uniform);
+        if (ret) {
+            const FOAM_UINT32 numPts = pointsFile_.getNumPts();
+            // Check if any face vertex indices are out of range
+            FOAM_UINT32 maxNdx = 0;
+            for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+                const FoamFace &face = faces[ii];
+                for (FOAM_UINT32 jj = 0; jj < face.vertCnt; ++jj) {
+                    maxNdx = std::max(maxNdx, face.index[jj]);
+                }
+            }
+            ret = (maxNdx < numPts);
+        }
+        return ret;
+    }
+
+
+    //! Sets the id, type and cells of the cnt faces starting at face first.
+    //! The first numNbors faces are interior (have owner and neighbor). The
+    //! remaining faces are boundary (no neighbor).
+    bool
+    readBatchCells(FOAM_UINT32 first, FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        const FOAM_UINT32 numNbors = neighborFile_.getNumLabels();
+        bool ret = true;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            FoamFace &face = faces[ii];
+            const FOAM_UINT32 ff = first + ii;
+            face.id = ff;
+            if (ff < numNbors) {
+                face.type = FOAM_FACETYPE_INTERIOR;
+                ret = readOwner(ff, face.owner) &&
+                    readNeighbor(ff, face.neighbor);
+            }
+            else {
+                face.type = FOAM_FACETYPE_BOUNDARY;
+                face.neighbor = FOAM_UINT32_MAX;
+                ret = readOwner(ff, face.owner);
+            }
+        }
+        return ret;
+    }
+
+
+    //! Reads a collated polyMesh and passes the merged mesh to handler.
+    bool readCollated(PolyMeshHandler &handler)
+    {
+        CollatedPolyMesh mesh;
+        return mesh.read(handler) && readCollatedPoints(handler, mesh) &&
+            readCollatedCells(handler, mesh);
+    }
+
+
+    bool readCollatedPoints(PolyMeshHandler &handler,
+        const CollatedPolyMesh &mesh)
+    {
+        const FOAM_UINT32 numPts = mesh.getNumPts();
+        bool ret = (0 != numPts) && handler.beginStep(numPts) &&
+            handler.beginPoints(numPts);
+        if (ret) {
+            std::vector<FoamPoint> pts(PolyMeshHandler::BatchSize);
+            for (FOAM_UINT32 ii = 0; ii < numPts && ret;) {
+                const FOAM_UINT32 cnt = std::min(numPts - ii,
+                    static_cast<FOAM_UINT32>(pts.size()));
+                for (FOAM_UINT32 jj = 0; jj < cnt; ++jj) {
+                    mesh.getPoint(ii + jj, pts[jj]);
+                }
+                ret = handler.pushPoints(ii, &pts[0], cnt) &&
+                    handler.stepIncr(cnt);
+                ii += cnt;
+            }
+            ret = ret && handler.endPoints();
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    bool readCollatedCells(PolyMeshHandler &handler,
+        const CollatedPolyMesh &mesh)
+    {
+        const FOAM_UINT32 numFaces = mesh.getNumFaces();
+        bool ret = handler.beginStep(numFaces) && handler.beginFaces(numFaces);
+        if (ret) {
+            FoamFace data;
+            batch_.resize(PolyMeshHandler::BatchSize);
+            for (FOAM_UINT32 ii = 0; ii < numFaces && ret; ++ii) {
+                mesh.getFace(ii, data);
+                orientFace(data);
+                ret = pushFace(handler, data);
+            }
+            // Stitch all the faces into cells
+            ret = ret && flushFaces(handler) && handler.endFaces();
+        }
+        return handler.endStep() && ret;
+    }
+
+
+    //! Appends face to the batch. Passes the batch to handler when full.
+    inline bool
+    pushFace(PolyMeshHandler &handler, const FoamFace &face)
+    {
+        batch_[batchCnt_] = face;
+        return (batch_.size() != ++batchCnt_) || flushFaces(handler);
+    }
+
+
+    //! Passes all batched faces to handler.
+    bool
+    flushFaces(PolyMeshHandler &handler)
+    {
+        const bool ret = (0 == batchCnt_) ||
+            (handler.pushFaces(&batch_[0], batchCnt_) &&
+                handler.stepIncr(batchCnt_));
+        batchCnt_ = 0;
+        return ret;
+    }
+
+private:
+    PolyMeshReader(const PolyMeshReader&);
+    const PolyMeshReader& operator=(const PolyMeshReader&);
+
+private:
+    ImportOptions       options_;
+    FoamTaskPool *      pool_;      //!< The pool for parallel stages or 0
+    FoamArchive         archive_;   //!< The archive if options_.archive is set
+    FoamArena           arena_;     //!< The staging buffer memory
+    FaceListFile        facesFile_;
+    LabelListFile       ownerFile_;
+    LabelListFile       neighborFile_;
+    VectorFieldFile     pointsFile_;
+    ZoneListFile        cellZonesFile_;
+    ZoneListFile        faceZonesFile_;
+    ZoneListFile        pointZonesFile_;
+    FaceArray1          batch_;     //!< The faces not yet passed to handler
+    FOAM_UINT32         batchCnt_;  //!< The number of faces in batch_
+    bool                preloaded_; //!< true if owners_ and neighbors_ are used
+    UInt32Array1        owners_;    //!< The preloaded owner labels
+    UInt32Array1        neighbors_; //!< The preloaded neighbour labels
+    FaceArray1          faces_;     //!< The faces read by loadFaces()
+};
+
+#endif // POLYMESHREADER_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
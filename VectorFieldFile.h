@@ -17,9 +17,8 @@
 #define VECTORFIELDFILE_H
 
 #include "FoamFile.h"
-
-#include "apiGRDPUtils.h"
-#include "apiGridModel.h"
+#include "FoamTypes.h"
+#include "PolyMeshHandler.h"
 
 #include <sstream>
 #include <vector>
@@ -34,6 +33,7 @@
 class VectorFieldFile : public FoamFile {
 
     typedef std::vector<std::string>    StringArray1;
+    typedef std::vector<FoamPoint>      PointArray1;
 
 public:
 
@@ -48,8 +48,8 @@ public:
     }
 
 
-    //! Read the vectors from file and store in hVL.
-    bool read(GRDP_RTITEM &rti, PWGM_HVERTEXLIST &hVL)
+    //! Read the vectors from file and pass them to handler in batches.
+    bool read(PolyMeshHandler &handler)
     {
         // afterReadHeader() leaves the file pos on the char AFTER the first (.
         //
@@ -64,34 +64,52 @@ public:
         // )
         // EOF
 
-        bool ret = (0 != numPts_) && PwVlstAllocate(hVL, numPts_);
-        if (ret && grdpProgressBeginStep(&rti, numPts_)) {
-            PWGM_VERTDATA vert = { 0 };
-            // parse all "(v0 v1 v2)" and store in hVL
+        bool ret = (0 != numPts_) && handler.beginStep(numPts_) &&
+            handler.beginPoints(numPts_);
+        if (ret) {
+            PointArray1 batch(PolyMeshHandler::BatchSize);
+            FOAM_UINT32 cnt = 0;
+            FOAM_UINT32 ii;
+            // parse all "(v0 v1 v2)" and pass to handler
             std::string xyz;
-            for (vert.i = 0; vert.i < numPts_ && ret; ++vert.i) {
+            for (ii = 0; ii < numPts_ && ret; ++ii) {
                 ret = wspaceSkipToChar('(') && readUntil(xyz, ')') &&
-                    setVertData(xyz, vert) &&
-                    PwVlstSetXYZData(hVL, vert.i, vert) &&
-                    grdpProgressIncr(&rti);
+                    setVertData(xyz, batch[cnt]);
+                if (ret && (batch.size() == ++cnt)) {
+                    ret = pushBatch(handler, ii + 1 - cnt, batch, cnt);
+                }
             }
+            ret = ret && pushBatch(handler, ii - cnt, batch, cnt);
             // There should be one ) remaining and then EOF
             ret = ret && wspaceSkipToChar(')') && wspaceCommentsSkip() &&
-                wspaceSkipToEOF();
+                wspaceSkipToEOF() && handler.endPoints();
         }
-        return grdpProgressEndStep(&rti) && ret;
+        return handler.endStep() && ret;
     }
 
 
-    inline PWP_UINT32   getNumPts() const {
+    inline FOAM_UINT32  getNumPts() const {
                             return numPts_; }
 
 
 private:
 
+    //! Passes the first cnt points of batch to handler and resets cnt.
+    static bool
+    pushBatch(PolyMeshHandler &handler, FOAM_UINT32 first,
+        const PointArray1 &batch, FOAM_UINT32 &cnt)
+    {
+        const bool ret = (0 == cnt) ||
+            (handler.pushPoints(first, &batch[0], cnt) &&
+                handler.stepIncr(cnt));
+        cnt = 0;
+        return ret;
+    }
+
+
     //! Parse the "double double double" string and store in vert
     bool
-    setVertData(const std::string &xyz, PWGM_VERTDATA &vert)
+    setVertData(const std::string &xyz, FoamPoint &vert)
     {
         StringArray1 toks;
         bool ret = (3 == tokenize(xyz, toks));
@@ -106,7 +124,7 @@ private:
 
 
     //! Split the space delimited str and store in toks
-    static PWP_UINT32
+    static FOAM_UINT32
     tokenize(const std::string &str, StringArray1 &toks)
     {
         toks.clear();
@@ -115,7 +133,7 @@ private:
         while (ss >> tok) {
             toks.push_back(tok);
         }
-        return static_cast<PWP_UINT32>(toks.size());
+        return static_cast<FOAM_UINT32>(toks.size());
     }
 
 
@@ -141,7 +159,7 @@ private:
 
 private:
 
-    PWP_UINT32  numPts_;    //!< The number of vector triples in this file
+    FOAM_UINT32  numPts_;    //!< The number of vector triples in this file
 };
 
 #endif // VECTORFIELDFILE_H
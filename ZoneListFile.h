@@ -0,0 +1,384 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef ZONELISTFILE_H
+#define ZONELISTFILE_H
+
+#include "FoamArchive.h"
+#include "FoamBuffer.h"
+#include "FoamTypes.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+//! A cell, face or point zone
+struct FoamZone {
+    FOAM_ZONETYPE               type;   //!< The zone type
+    std::string                 name;   //!< The zone name
+    std::vector<FOAM_UINT32>    labels; //!< The sorted member indices
+    std::vector<unsigned char>  flips;  //!< The face flip flags (faces only)
+};
+
+typedef std::vector<FoamZone>   FoamZoneArray1;
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! Reads a cellZones, faceZones or pointZones file.
+
+    The file is mapped and each zone's label list is decoded in bulk. ASCII
+    lists are decoded with a tight digit scan. Binary lists are copied
+    directly from the mapped bytes (32 or 64 bit labels). Both the "N(...)"
+    and uniform "N{v}" list forms are supported. The labels of each zone are
+    returned sorted so they can be applied with a single merge pass.
+
+    The file looks like:
+
+        N
+        (
+        zoneName
+        {
+            type cellZone;
+            cellLabels List<label> M ( ... );
+        }
+        ...
+        )
+
+    A faceZones entry also has a "flipMap List<bool> M ( ... );" entry.
+*/
+class ZoneListFile {
+
+    typedef std::vector<FOAM_UINT32>    UInt32Array1;
+
+public:
+
+    ZoneListFile(const char *baseName, FOAM_ZONETYPE type) :
+        baseName_(baseName),
+        type_(type),
+        labelsKey_((FOAM_ZONETYPE_CELL == type) ? "cellLabels" :
+            ((FOAM_ZONETYPE_FACE == type) ? "faceLabels" : "pointLabels")),
+        archive_(0),
+        file_(),
+        data_(),
+        binary_(false),
+        labelBytes_(4)
+    {
+    }
+
+    ~ZoneListFile()
+    {
+    }
+
+
+    //! Reads the file from archive instead of the cwd. Pass 0 to read from
+    //! the cwd again.
+    inline void     setArchive(const FoamArchive *archive) {
+                        archive_ = archive; }
+
+
+    //! \return true if the file exists.
+    bool
+    exists() const
+    {
+        const char *data;
+        size_t size;
+        if (0 != archive_) {
+            return archive_->find(baseName_, data, size);
+        }
+        FILE *fp = std::fopen(baseName_.c_str(), "rb");
+        if (0 != fp) {
+            std::fclose(fp);
+        }
+        return 0 != fp;
+    }
+
+
+    //! Reads all zones in the file and appends them to zones.
+    bool
+    read(FoamZoneArray1 &zones)
+    {
+        FoamBuffer::StringStringMap hdrVals;
+        FOAM_UINT32 numZones = 0;
+        const char *begin = 0;
+        size_t size = 0;
+        // An archive member is parsed in place
+        bool ret = (0 != archive_) ? archive_->find(baseName_, begin, size) :
+            file_.open(baseName_.c_str());
+        if (ret && (0 == archive_)) {
+            begin = file_.begin();
+            size = file_.size();
+        }
+        if (ret) {
+            data_ = FoamBuffer(begin, begin + size);
+            ret = data_.readHeader(hdrVals) && readFormat(hdrVals) &&
+                data_.readListBegin(numZones);
+        }
+        for (FOAM_UINT32 ii = 0; ii < numZones && ret; ++ii) {
+            zones.push_back(FoamZone());
+            ret = readZone(zones.back());
+        }
+        ret = ret && data_.readListEnd();
+        file_.close();
+        return ret;
+    }
+
+private:
+
+    //! Loads the format and label size from the header.
+    bool
+    readFormat(FoamBuffer::StringStringMap &hdrVals)
+    {
+        const std::string &format = hdrVals["format"];
+        const std::string &arch = hdrVals["arch"];
+        binary_ = ("binary" == format);
+        labelBytes_ = (std::string::npos != arch.find("label=64")) ? 8 : 4;
+        // Binary data must have the same byte order as this machine
+        const FOAM_UINT32 one = 1;
+        const bool isLsb = (1 == *reinterpret_cast<const unsigned char*>(&one));
+        const bool archLsb = (std::string::npos == arch.find("MSB"));
+        return ("ascii" == format) || (binary_ && (isLsb == archLsb));
+    }
+
+
+    bool
+    readZone(FoamZone &zone)
+    {
+        zone.type = type_;
+        bool ret = data_.wspaceCommentsSkip() && data_.readToken(zone.name) &&
+            data_.wspaceCommentsSkip() && data_.wspaceSkipToChar('{');
+        std::string tok;
+        std::string val;
+        bool hasLabels = false;
+        while (ret) {
+            ret = data_.wspaceCommentsSkip();
+            if (ret && data_.wspaceSkipToChar('}')) {
+                break;
+            }
+            ret = ret && data_.readToken(tok);
+            if (ret && (labelsKey_ == tok)) {
+                // The labels of a zone are distinct, so only a list of one
+                // label can be uniform
+                ret = readList(zone.labels, labelBytes_, 1);
+                hasLabels = true;
+            }
+            else if (ret && ("flipMap" == tok)) {
+                // A uniform flipMap has one flag per label. If the labels
+                // follow, each takes at least minBytes(labelBytes_).
+                const FOAM_UINT64 maxUniform = hasLabels ?
+                    zone.labels.size() :
+                    static_cast<FOAM_UINT64>(data_.end() - data_.pos()) /
+                        minBytes(labelBytes_);
+                // binary bools are one byte each
+                UInt32Array1 flips;
+                ret = readList(flips, 1, maxUniform);
+                zone.flips.assign(flips.begin(), flips.end());
+            }
+            else if (ret) {
+                // type, inGroups, ...
+                ret = data_.readUntilTrim(val, ';');
+            }
+        }
+        ret = ret && (zone.flips.empty() ||
+            (zone.flips.size() == zone.labels.size()));
+        if (ret) {
+            sortZone(zone);
+        }
+        return ret;
+    }
+
+
+    //! Reads a "[List<T>] N (v0 v1 ...);" or "[List<T>] N {v};" entry.
+    //! elemBytes is the size of each value in a binary file. N is checked
+    //! before vals is sized. A uniform list may have at most maxUniform
+    //! values and the rest of the file must hold the values of any other.
+    bool
+    readList(UInt32Array1 &vals, size_t elemBytes, FOAM_UINT64 maxUniform)
+    {
+        FOAM_UINT32 cnt = 0;
+        std::string tok;
+        bool ret = data_.wspaceCommentsSkip();
+        if (ret && (5 <= (data_.end() - data_.pos())) &&
+                (0 == std::memcmp(data_.pos(), "List<", 5))) {
+            ret = data_.readToken(tok);
+        }
+        ret = ret && data_.readInt(cnt) && data_.wspaceSkip();
+        if (ret && ('{' == *data_.pos())) {
+            // uniform list. A binary value is always written as a label.
+            data_.setPos(data_.pos() + 1);
+            FOAM_UINT32 val = 0;
+            ret = (cnt <= maxUniform) && (binary_ ?
+                decodeBinary(&val, 1, labelBytes_) : decodeAscii(&val, 1)) &&
+                data_.wspaceSkipToChar('}');
+            if (ret) {
+                vals.assign(cnt, val);
+            }
+        }
+        else if (ret && ('(' == *data_.pos())) {
+            data_.setPos(data_.pos() + 1);
+            ret = (cnt * minBytes(elemBytes) <=
+                static_cast<FOAM_UINT64>(data_.end() - data_.pos()));
+            if (ret) {
+                vals.resize(cnt);
+            }
+            ret = ret && ((0 == cnt) || (binary_ ?
+                decodeBinary(&vals[0], cnt, elemBytes) :
+                decodeAscii(&vals[0], cnt)));
+            ret = ret && data_.wspaceSkipToChar(')');
+        }
+        else {
+            ret = false;
+        }
+        return ret && data_.wspaceSkipToChar(';');
+    }
+
+
+    //! \return The fewest bytes a list value of elemBytes binary bytes
+    //! takes. An ascii value is at least a digit and a delimiter.
+    inline FOAM_UINT64
+    minBytes(size_t elemBytes) const
+    {
+        return binary_ ? elemBytes : 2;
+    }
+
+
+    //! Decodes cnt white space delimited labels.
+    bool
+    decodeAscii(FOAM_UINT32 *vals, FOAM_UINT32 cnt)
+    {
+        const unsigned char *p =
+            reinterpret_cast<const unsigned char*>(data_.pos());
+        const unsigned char *end =
+            reinterpret_cast<const unsigned char*>(data_.end());
+        FOAM_UINT32 ii = 0;
+        while ((ii < cnt) && (p < end)) {
+            unsigned int digit = *p - '0';
+            if (digit < 10) {
+                FOAM_UINT64 val = 0;
+                do {
+                    val = (val * 10) + digit;
+                    ++p;
+                } while ((p < end) && ((digit = *p - '0') < 10));
+                if (FOAM_UINT32_MAX <= val) {
+                    break;
+                }
+                vals[ii++] = static_cast<FOAM_UINT32>(val);
+            }
+            else if (std::isspace(*p)) {
+                ++p;
+            }
+            else {
+                break;
+            }
+        }
+        data_.setPos(reinterpret_cast<const char*>(p));
+        return ii == cnt;
+    }
+
+
+    //! Copies cnt binary values of elemBytes each.
+    bool
+    decodeBinary(FOAM_UINT32 *vals, FOAM_UINT32 cnt, size_t elemBytes)
+    {
+        const char *p = data_.pos();
+        const size_t numBytes = elemBytes * cnt;
+        bool ret = (numBytes <= static_cast<size_t>(data_.end() - p));
+        if (ret && (4 == elemBytes)) {
+            std::memcpy(vals, p, numBytes);
+            for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+                // negative labels are invalid
+                ret = (vals[ii] < 0x80000000U);
+            }
+        }
+        else if (ret && (8 == elemBytes)) {
+            for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+                FOAM_INT64 val;
+                std::memcpy(&val, p + 8 * static_cast<size_t>(ii), 8);
+                vals[ii] = static_cast<FOAM_UINT32>(val);
+                ret = (0 <= val) && (val < FOAM_INT64(FOAM_UINT32_MAX));
+            }
+        }
+        else if (ret) {
+            for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+                vals[ii] = static_cast<unsigned char>(p[ii]);
+            }
+        }
+        if (ret) {
+            data_.setPos(p + numBytes);
+        }
+        return ret;
+    }
+
+
+    //! Sorts the zone labels (and flips) if they are not already sorted.
+    static void
+    sortZone(FoamZone &zone)
+    {
+        UInt32Array1 &labels = zone.labels;
+        if (std::is_sorted(labels.begin(), labels.end())) {
+            // OpenFOAM normally writes sorted zones
+        }
+        else if (zone.flips.empty()) {
+            std::sort(labels.begin(), labels.end());
+        }
+        else {
+            // Sort (label, flip) pairs
+            std::vector<FOAM_UINT64> pairs(labels.size());
+            for (size_t ii = 0; ii < labels.size(); ++ii) {
+                pairs[ii] = (static_cast<FOAM_UINT64>(labels[ii]) << 1) |
+                    (zone.flips[ii] ? 1 : 0);
+            }
+            std::sort(pairs.begin(), pairs.end());
+            for (size_t ii = 0; ii < labels.size(); ++ii) {
+                labels[ii] = static_cast<FOAM_UINT32>(pairs[ii] >> 1);
+                zone.flips[ii] = static_cast<unsigned char>(pairs[ii] & 1);
+            }
+        }
+    }
+
+private:
+    ZoneListFile(const ZoneListFile&);
+    const ZoneListFile& operator=(const ZoneListFile&);
+
+private:
+    std::string         baseName_;      //!< The file name
+    FOAM_ZONETYPE       type_;          //!< The zone type in this file
+    std::string         labelsKey_;     //!< The keyword of the label list
+    const FoamArchive * archive_;       //!< The archive to read from or 0
+    FoamMappedFile      file_;          //!< The mapped file while reading
+    FoamBuffer          data_;          //!< The parse cursor
+    bool                binary_;        //!< true if format is binary
+    size_t              labelBytes_;    //!< The binary label size
+};
+
+#endif // ZONELISTFILE_H
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -52,13 +52,8 @@
     {0},  // clock_t clocks[GRDP_CLKS_SIZE];
     0,    // PWP_BOOL opAborted
 
-    // If you added any custom data in rtCaepInstanceData.h,
-    // you need to initialize it here. The init below matches the 
-    // example MY_GRDP_DATA struct given in rtCaepInstanceData.h */
-    //{   0,
-    //    0,
-    //    0.0,
-    //    "string" },
+    // Custom data declared in rtGrdpInstanceData.h
+    0,    // void *pTaskPool
 },
 
 #endif /* _RTGRDPINITITEMS_H_ */
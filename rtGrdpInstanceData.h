@@ -0,0 +1,39 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+#ifndef _RTGRDPINSTANCEDATA_H_
+#define _RTGRDPINSTANCEDATA_H_
+
+/*! Custom GRDP_RTITEM members. This file is included inside the GRDP_RTITEM
+    struct. Every member must be initialized in rtGrdpInitItems.h.
+*/
+
+//! The FoamTaskPool owned by the plugin. It is created by
+//! runtimeReadGridCreate() and deleted by runtimeReadGridDestroy().
+void *pTaskPool;
+
+#endif /* _RTGRDPINSTANCEDATA_H_ */
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -13,200 +13,396 @@
 *
 ***************************************************************************/
 
-#include "FaceListFile.h"
-#include "LabelListFile.h"
-#include "VectorFieldFile.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "ImportOptions.h"
+#include "PolyMeshHandler.h"
+#include "PolyMeshReader.h"
+#include "ZoneListFile.h"
 
 #include "apiGRDP.h"
 #include "apiGRDPUtils.h"
 #include "apiGridModel.h"
 #include "apiPWP.h"
+#include "apiUtils.h"
 #include "runtimeReadGrid.h"
 
-#include <algorithm> // for swap() < C++11
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <new>
 #include <string>
-//#include <utility> // for swap() >= C++11
-
-
-// Swaps face indices so the face normal is reversed
-inline static void
-reverseFace(PWGM_ASSEMBLER_DATA &face)
-{
-    if (4 == face.vertCnt) {
-        std::swap(face.index[1], face.index[3]);
-    }
-    else if (3 == face.vertCnt) {
-        std::swap(face.index[1], face.index[2]);
-    }
-    else {
-        // Could not reverse an unsupported face type
-        ASSERT(false);
-    }
-}
+#include <system_error>
+#include <vector>
 
 
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 
-class OpenFOAMGridReader {
+/*! Feeds the points and faces produced by PolyMeshReader to the grid model
+    and maps the reader's progress steps to the GRDP progress API.
+
+    By default, all cells are assembled into one block. If
+    ImportOptions::cellZoneBlocks is set, each non-empty cellZone is assembled
+    into its own block and the cells not in any zone into one more block. A
+    face between two zones becomes a boundary face of both blocks. If
+    ImportOptions::faceZoneBaffles is set, each interior face in a faceZone
+    also becomes a boundary face of both its cells. The grid model has no
+    point sets, so the pointZones are ignored.
+*/
+class GrdpMeshHandler : public PolyMeshHandler {
+
+    typedef std::vector<FOAM_UINT32>            UInt32Array1;
+    typedef std::vector<bool>                   BoolArray1;
+    typedef std::vector<PWGM_HBLOCKASSEMBLER>   AssemblerArray1;
+    typedef std::chrono::steady_clock           Clock;
+
+    enum {
+        QuitPollMs = 100    //!< The min time between host abort queries
+    };
+
 public:
 
-    OpenFOAMGridReader(GRDP_RTITEM &rti) :
+    GrdpMeshHandler(GRDP_RTITEM &rti, const ImportOptions &options) :
         rti_(rti),
+        zoneBlocks_(options.cellZoneBlocks),
+        zoneBaffles_(options.faceZoneBaffles),
         hVL_(PwModCreateUnsVertexList(rti.model)),
-        facesFile_("faces"),
-        ownerFile_("owner"),
-        neighborFile_("neighbour"),
-        pointsFile_("points")
+        hAsm_(),
+        numCellZones_(0),
+        cellZone_(),
+        cellLocal_(),
+        numUnzoned_(0),
+        cellHasFace_(),
+        isBaffle_(),
+        hZoneAsms_(),
+        nextQuitPoll_()
     {
     }
 
-    ~OpenFOAMGridReader()
+    virtual ~GrdpMeshHandler()
     {
     }
 
 
-    PWP_BOOL
-    read()
+    virtual bool
+    beginRead(FOAM_UINT32 numSteps)
     {
-        // Open files and do some sanity checks before doing heavy lifting.
-        // All faces have owners (numOwners == numFaces).
-        // Only internal faces have neighbors (numNeighbors < numFaces)
-        const PWP_UINT32 NumMajorSteps = 4;
-        return grdpProgressEnd(&rti_, grdpProgressInit(&rti_, NumMajorSteps) &&
-            pointsFile_.open() && facesFile_.open() && ownerFile_.open() &&
-            neighborFile_.open() &&
-            (ownerFile_.getNumLabels() == facesFile_.getNumFaces()) &&
-            (neighborFile_.getNumLabels() < facesFile_.getNumFaces()) &&
-            pointsFile_.read(rti_, hVL_) && readCells());
+        return 0 != grdpProgressInit(&rti_, numSteps);
     }
 
 
-private:
+    virtual bool
+    beginStep(FOAM_UINT32 total)
+    {
+        return 0 != grdpProgressBeginStep(&rti_, total);
+    }
 
-    bool readCells()
+
+    virtual bool
+    stepIncr(FOAM_UINT32 cnt)
     {
-        const PWP_UINT32 numFaces = facesFile_.getNumFaces();
-        PWGM_HBLOCKASSEMBLER hAsm = PwVlstCreateBlockAssembler(hVL_);
-        bool ret = PWGM_HBLOCKASSEMBLER_ISVALID(hAsm);
-        if (ret && grdpProgressBeginStep(&rti_, numFaces)) {
-            PWGM_ASSEMBLER_DATA data;
-            PWP_UINT32 ii;
-            // The first numNbors faces are interior (have owner and neighbor)
-            data.type = PWGM_FACETYPE_INTERIOR;
-            const PWP_UINT32 numNbors = neighborFile_.getNumLabels();
-            for (ii = 0; ii < numNbors; ++ii) {
-                if (!readFaceVertices(data)) {
-                    ret = false;
-                    break;
-                }
-                if (!ownerFile_.readNextLabel(data.owner) ||
-                        !neighborFile_.readNextLabel(data.neighbor)) {
-                    ret = false;
-                    break;
-                }
-                if (data.owner < data.neighbor) {
-                    // The OpenFOAM spec requires:
-                    // * An internal-face's normal points from the cell with the
-                    //   lower index towards the cell with the higher index.
-                    // * A boundary-face's normal points outside the owner cell.
-                    //
-                    // The GRDP spec requires:
-                    // * An internal-face's normal points from the neighbor cell
-                    //   towards the owner cell.
-                    // * A boundary-face's normal points into the owner cell.
-                    //
-                    //               --- InteriorFaceNormal --->
-                    //  OpenFOAM  Cell[LowNdx]        Cell[HighNdx]
-                    //  GRDP API  Cell[NeighborNdx]   Cell[OwnerNdx]
-                    //
-                    //               --- BndryFaceNormal --->
-                    //  OpenFOAM  Cell[OwnerNdx]   (GridExterior)
-                    //  GRDP API  (GridExterior)   Cell[OwnerNdx]
-
-                    // Since the OF owner index is < OF neighbor index, the face
-                    // normal is wrong direction for PW. We could reverse the
-                    // face vertices, but swapping the cell indices is faster.
-                    std::swap(data.owner, data.neighbor);
-                }
-                // Add face to the assembler
-                if (!PwAsmPushElementFace(hAsm, &data) ||
-                        !grdpProgressIncr(&rti_)) {
-                    ret = false;
-                    break;
+        bool ret = true;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            ret = (0 != grdpProgressIncr(&rti_));
+        }
+        return ret;
+    }
+
+
+    virtual bool
+    endStep()
+    {
+        return 0 != grdpProgressEndStep(&rti_);
+    }
+
+
+    //! opAborted is only refreshed by the grdpProgress calls, and none run
+    //! while a parallel stage works, so the host is queried directly. Each
+    //! query is a round trip, so a cancel is seen within QuitPollMs plus the
+    //! pool's poll interval.
+    virtual bool
+    isAborted()
+    {
+        const Clock::time_point now = Clock::now();
+        if ((0 == rti_.opAborted) && (now >= nextQuitPoll_)) {
+            nextQuitPoll_ = now + std::chrono::milliseconds(QuitPollMs);
+            if (PwuProgressQuit(rti_.pApiData->apiInfo.name)) {
+                rti_.opAborted = PWP_TRUE;
+            }
+        }
+        return 0 != rti_.opAborted;
+    }
+
+
+    virtual bool
+    beginPoints(FOAM_UINT32 numPts)
+    {
+        return 0 != PwVlstAllocate(hVL_, numPts);
+    }
+
+
+    virtual bool
+    pushPoints(FOAM_UINT32 first, const FoamPoint *pts, FOAM_UINT32 cnt)
+    {
+        bool ret = true;
+        PWGM_VERTDATA vert;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            vert.x = pts[ii].x;
+            vert.y = pts[ii].y;
+            vert.z = pts[ii].z;
+            vert.i = first + ii;
+            ret = (0 != PwVlstSetXYZData(hVL_, vert.i, vert));
+        }
+        return ret;
+    }
+
+
+    virtual bool
+    endPoints()
+    {
+        return true;
+    }
+
+
+    virtual bool
+    pushZones(const FoamZone *zones, FOAM_UINT32 cnt)
+    {
+        // The reader range checks the labels, so the tables are sized once
+        // to the largest zoned label. Cells and faces past it are not zoned.
+        size_t numTable = 0;
+        size_t numFaces = 0;
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            const FoamZone &zone = zones[ii];
+            if (zone.labels.empty()) {
+                continue;
+            }
+            const size_t num = static_cast<size_t>(zone.labels.back()) + 1;
+            if (zoneBlocks_ && (FOAM_ZONETYPE_CELL == zone.type)) {
+                numTable = std::max(numTable, num);
+            }
+            else if (zoneBaffles_ && (FOAM_ZONETYPE_FACE == zone.type)) {
+                numFaces = std::max(numFaces, num);
+            }
+        }
+        try {
+            cellZone_.assign(numTable, FOAM_UINT32_MAX);
+            cellLocal_.assign(numTable, FOAM_UINT32_MAX);
+            cellHasFace_.assign(numTable, false);
+            isBaffle_.assign(numFaces, false);
+        }
+        catch (const std::bad_alloc &) {
+            return false;
+        }
+        for (FOAM_UINT32 ii = 0; ii < cnt && (0 != numFaces); ++ii) {
+            const FoamZone &zone = zones[ii];
+            if (FOAM_ZONETYPE_FACE == zone.type) {
+                for (size_t jj = 0; jj < zone.labels.size(); ++jj) {
+                    isBaffle_[zone.labels[jj]] = true;
                 }
             }
-            // There should be one ) remaining and then EOF
-            ret = ret && neighborFile_.wspaceSkipToChar(')') &&
-                neighborFile_.wspaceCommentsSkip() &&
-                neighborFile_.wspaceSkipToEOF();
-
-            if (ret) {
-                // The remaining faces are boundary (no neighbor)
-                data.type = PWGM_FACETYPE_BOUNDARY;
-                data.neighbor = PWP_UINT32_MAX;
-                for (; ii < numFaces; ++ii) {
-                    if (!readFaceVertices(data)) {
-                        ret = false;
-                        break;
-                    }
-                    if (!ownerFile_.readNextLabel(data.owner)) {
-                        ret = false;
-                        break;
-                    }
-                    // OF boundary faces always have the wrong face normal for
-                    // PW. Need to reverse the face so the normal points INTO
-                    // the owner cell.
-                    reverseFace(data);
-
-                    // Add face to the assembler
-                    if (!PwAsmPushElementFace(hAsm, &data) ||
-                            !grdpProgressIncr(&rti_)) {
-                        ret = false;
-                        break;
-                    }
+        }
+        if (0 == numTable) {
+            return true;
+        }
+        // Number the cells of each non-empty cell zone. A cell listed by more
+        // than one zone stays in the first.
+        for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+            const FoamZone &zone = zones[ii];
+            if ((FOAM_ZONETYPE_CELL != zone.type) || zone.labels.empty()) {
+                continue;
+            }
+            const FOAM_UINT32 zoneNdx = numCellZones_++;
+            FOAM_UINT32 numLocal = 0;
+            for (size_t jj = 0; jj < zone.labels.size(); ++jj) {
+                const FOAM_UINT32 cell = zone.labels[jj];
+                if (FOAM_UINT32_MAX == cellZone_[cell]) {
+                    cellZone_[cell] = zoneNdx;
+                    cellLocal_[cell] = numLocal++;
                 }
-                // There should be one ) remaining and then EOF
-                ret = ret && ownerFile_.wspaceSkipToChar(')') &&
-                    ownerFile_.wspaceCommentsSkip() &&
-                    ownerFile_.wspaceSkipToEOF();
             }
         }
-        // Stitch all the faces into cells
-        return grdpProgressEndStep(&rti_) && ret && PwAsmFinalize(hAsm);
+        // The last zone holds the cells not in any cell zone, numbered in
+        // cell order
+        for (size_t cell = 0; cell < numTable; ++cell) {
+            if (FOAM_UINT32_MAX == cellZone_[cell]) {
+                cellZone_[cell] = numCellZones_;
+                cellLocal_[cell] = numUnzoned_++;
+            }
+        }
+        return true;
     }
 
 
-    bool readFaceVertices(PWGM_ASSEMBLER_DATA &data)
+    virtual bool
+    beginFaces(FOAM_UINT32 numFaces)
     {
-        bool ret = facesFile_.readNextFace(data);
-        if (ret) {
-            const PWP_UINT32 numPts = pointsFile_.getNumPts();
-            // Check if any face vertex indices are out of range
-            for (PWP_UINT32 jj = 0; jj < data.vertCnt; ++jj) {
-                if (numPts <= data.index[jj]) {
-                    ret = false;
-                    break;
-                }
-            }
+        (void)numFaces;
+        bool ret = true;
+        if (!isSplit()) {
+            hAsm_ = PwVlstCreateBlockAssembler(hVL_);
+            ret = PWGM_HBLOCKASSEMBLER_ISVALID(hAsm_);
+        }
+        else {
+            // The zone assemblers are created by their first face
+            hZoneAsms_.resize(numCellZones_ + 1);
+        }
+        return ret;
+    }
+
+
+    virtual bool
+    pushFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        if (isSplit()) {
+            return pushZoneFaces(faces, cnt);
+        }
+        bool ret = true;
+        PWGM_ASSEMBLER_DATA data;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            setAssemblerData(faces[ii], data);
+            // Add face to the assembler
+            ret = (0 != PwAsmPushElementFace(hAsm_, &data));
         }
         return ret;
     }
 
 
+    virtual bool
+    endFaces()
+    {
+        // Stitch all the faces into cells
+        bool ret = true;
+        if (!isSplit()) {
+            ret = (0 != PwAsmFinalize(hAsm_));
+        }
+        else {
+            // A zoned cell without faces leaves a hole in its zone's block
+            ret = (cellHasFace_.end() ==
+                std::find(cellHasFace_.begin(), cellHasFace_.end(), false));
+        }
+        for (size_t ii = 0; ii < hZoneAsms_.size() && ret; ++ii) {
+            ret = !PWGM_HBLOCKASSEMBLER_ISVALID(hZoneAsms_[ii]) ||
+                (0 != PwAsmFinalize(hZoneAsms_[ii]));
+        }
+        return ret;
+    }
+
 private:
-    OpenFOAMGridReader(const OpenFOAMGridReader&);
-    const OpenFOAMGridReader& operator=(const OpenFOAMGridReader&);
 
+    //! \return true if the faces are routed to more than one block or any
+    //! interior face is split
+    inline bool
+    isSplit() const
+    {
+        return (0 != numCellZones_) || !isBaffle_.empty();
+    }
+
+
+    static void
+    setAssemblerData(const FoamFace &face, PWGM_ASSEMBLER_DATA &data)
+    {
+        data.type = (FOAM_FACETYPE_INTERIOR == face.type) ?
+            PWGM_FACETYPE_INTERIOR : PWGM_FACETYPE_BOUNDARY;
+        data.owner = face.owner;
+        data.neighbor = face.neighbor;
+        data.vertCnt = face.vertCnt;
+        for (FOAM_UINT32 jj = 0; jj < face.vertCnt; ++jj) {
+            data.index[jj] = face.index[jj];
+        }
+    }
+
+
+    //! \return The zone of cell. The cell's index in the zone's block is
+    //! returned in local.
+    inline FOAM_UINT32
+    getZoneCell(FOAM_UINT32 cell, FOAM_UINT32 &local)
+    {
+        if (cellZone_.size() <= cell) {
+            // Cells past the tables are not in any cell zone
+            local = numUnzoned_ +
+                (cell - static_cast<FOAM_UINT32>(cellZone_.size()));
+            return numCellZones_;
+        }
+        cellHasFace_[cell] = true;
+        local = cellLocal_[cell];
+        return cellZone_[cell];
+    }
+
+
+    //! Adds a face to the block assembler of zone.
+    bool
+    pushZoneFace(FOAM_UINT32 zone, PWGM_ASSEMBLER_DATA &data)
+    {
+        PWGM_HBLOCKASSEMBLER &hAsm = hZoneAsms_[zone];
+        if (!PWGM_HBLOCKASSEMBLER_ISVALID(hAsm)) {
+            hAsm = PwVlstCreateBlockAssembler(hVL_);
+        }
+        return PWGM_HBLOCKASSEMBLER_ISVALID(hAsm) &&
+            (0 != PwAsmPushElementFace(hAsm, &data));
+    }
+
+
+    //! Routes each face to the block assembler of its cells' zones. Without
+    //! cell zone blocks, every cell is in the unzoned block.
+    bool
+    pushZoneFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        bool ret = true;
+        PWGM_ASSEMBLER_DATA data;
+        FOAM_UINT32 ownLocal;
+        FOAM_UINT32 nbrLocal;
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            const FoamFace &face = faces[ii];
+            setAssemblerData(face, data);
+            const FOAM_UINT32 ownZone = getZoneCell(face.owner, ownLocal);
+            data.owner = ownLocal;
+            if (FOAM_FACETYPE_INTERIOR != face.type) {
+                ret = pushZoneFace(ownZone, data);
+                continue;
+            }
+            const FOAM_UINT32 nbrZone = getZoneCell(face.neighbor, nbrLocal);
+            const bool isBaffle = (face.id < isBaffle_.size()) &&
+                isBaffle_[face.id];
+            if ((ownZone == nbrZone) && !isBaffle) {
+                data.neighbor = nbrLocal;
+                ret = pushZoneFace(ownZone, data);
+                continue;
+            }
+            // The face is a boundary of both cells. The face normal
+            // already points into the owner. It must be reversed to point
+            // into the neighbor.
+            data.type = PWGM_FACETYPE_BOUNDARY;
+            ret = pushZoneFace(ownZone, data);
+            FoamFace nbrFace = face;
+            reverseFace(nbrFace);
+            setAssemblerData(nbrFace, data);
+            data.type = PWGM_FACETYPE_BOUNDARY;
+            data.owner = nbrLocal;
+            ret = ret && pushZoneFace(nbrZone, data);
+        }
+        return ret;
+    }
+
+private:
+    GrdpMeshHandler(const GrdpMeshHandler&);
+    const GrdpMeshHandler& operator=(const GrdpMeshHandler&);
 
 private:
-    GRDP_RTITEM &       rti_;
-    PWGM_HVERTEXLIST    hVL_;
-    FaceListFile        facesFile_;
-    LabelListFile       ownerFile_;
-    LabelListFile       neighborFile_;
-    VectorFieldFile     pointsFile_; 
+    GRDP_RTITEM &           rti_;
+    const bool              zoneBlocks_;    //!< One block per cell zone
+    const bool              zoneBaffles_;   //!< Split the face zone faces
+    PWGM_HVERTEXLIST        hVL_;
+    PWGM_HBLOCKASSEMBLER    hAsm_;
+    FOAM_UINT32             numCellZones_;  //!< The non-empty cell zones
+    UInt32Array1            cellZone_;      //!< The zone of each cell
+    UInt32Array1            cellLocal_;     //!< The block index of each cell
+    FOAM_UINT32             numUnzoned_;    //!< The unzoned cells in tables
+    BoolArray1              cellHasFace_;   //!< Whether each cell has a face
+    BoolArray1              isBaffle_;      //!< Whether each face is split
+    AssemblerArray1         hZoneAsms_;     //!< The block of each zone
+    Clock::time_point       nextQuitPoll_;  //!< The next host abort query
 };
 
 
@@ -214,8 +410,21 @@ private:
 PWP_BOOL
 runtimeReadGrid(GRDP_RTITEM *pRti)
 {
-    OpenFOAMGridReader grid(*pRti);
-    return grid.read();
+    // The reader sizes its arrays from counts read from the files. A bad
+    // count may throw std::bad_alloc or std::length_error, and no exception
+    // may escape into the host.
+    bool ret;
+    try {
+        const ImportOptions options;
+        GrdpMeshHandler handler(*pRti, options);
+        PolyMeshReader reader(options,
+            static_cast<FoamTaskPool*>(pRti->pTaskPool));
+        ret = reader.read(handler);
+    }
+    catch (const std::exception &) {
+        ret = false;
+    }
+    return grdpProgressEnd(pRti, ret);
 }
 
 
@@ -236,7 +445,6 @@ assignValueEnum(const char name[], const char value[],
 PWP_BOOL
 runtimeReadGridCreate(GRDP_RTITEM *pRti)
 {
-    (void)pRti;
     PWP_BOOL ret = PWP_TRUE;
 
     // Element types supported by this importer
@@ -248,6 +456,32 @@ runtimeReadGridCreate(GRDP_RTITEM *pRti)
     const char *filters = "faces owner neighbour points";
     ret = ret && assignValueEnum("FileFilters", filters, true);
 
+    // The thread pool used by every import of this plugin instance. No
+    // exception may escape into the host, and starting a thread throws
+    // std::system_error if the system cannot create it.
+    const ImportOptions options;
+    FoamTaskPool *pool = 0;
+    try {
+        pool = new FoamTaskPool(static_cast<FOAM_UINT32>(options.numThreads));
+    }
+    catch (const std::bad_alloc &) {
+        pool = 0;
+    }
+    catch (const std::system_error &) {
+        pool = 0;
+    }
+    pRti->pTaskPool = pool;
+    ret = ret && (0 != pool);
+    if (ret) {
+        // Invalid entries are ignored
+        pool->setGrains(options.taskGrains);
+        // ThreadCount only shows the pool size. The size comes from the
+        // PW_OPENFOAM_THREADS env var and a new ThreadCount value is not
+        // read back, so it cannot resize the pool.
+        const std::string numThreads = std::to_string(pool->getNumThreads());
+        ret = assignValueEnum("ThreadCount", numThreads.c_str(), true);
+    }
+
     return ret;
 }
 
@@ -261,7 +495,9 @@ runtimeReadGridCreate(GRDP_RTITEM *pRti)
 PWP_VOID
 runtimeReadGridDestroy(GRDP_RTITEM *pRti)
 {
-    (void)pRti;
+    // Stops and joins the pool threads
+    delete static_cast<FoamTaskPool*>(pRti->pTaskPool);
+    pRti->pTaskPool = 0;
 }
 
 
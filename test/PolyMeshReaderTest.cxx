@@ -0,0 +1,1674 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+*
+* OpenFOAM Grid Import Plugin (GRDP)
+*
+***************************************************************************/
+
+/*! \file
+    Builds the SDK-free reader core against a mock PolyMeshHandler.
+
+    Small hex and tet block meshes are generated in the cwd and read back
+    with each import option. The handler checks the call sequence, that
+    every point and face arrives once, and that every face is oriented into
+    its owner cell as PolyMeshHandler::pushFaces() requires. Each parallel
+    stage is also cancelled at each of its polls and must fail cleanly.
+    Truncated and miscounted files must be rejected by the prescan. The
+    mesh headers are probed from files, an archive and collated files. The
+    zone files are read in each format and bad zones must be rejected.
+    The mesh is also read from tar and gzip compressed tar archives, and
+    truncated archives must be rejected. The quality report must match the
+    face areas, cell volumes, non-orthogonality and skewness of the mesh.
+*/
+
+#include "CellFaceCsr.h"
+#include "FoamTaskPool.h"
+#include "FoamTypes.h"
+#include "ImportOptions.h"
+#include "PolyMeshHandler.h"
+#include "PolyMeshProbe.h"
+#include "PolyMeshReader.h"
+#include "PointCompactor.h"
+#include "ZoneListFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(FOAM_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+
+typedef std::vector<FOAM_UINT32>    UInt32Array1;
+typedef std::vector<UInt32Array1>   UInt32Array2;
+typedef std::vector<FoamPoint>      PointArray1;
+typedef std::vector<double>         DoubleArray1;
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+//! \return a - b
+inline static FoamPoint
+sub(const FoamPoint &a, const FoamPoint &b)
+{
+    FoamPoint ret = { a.x - b.x, a.y - b.y, a.z - b.z };
+    return ret;
+}
+
+
+//! \return a . b
+inline static double
+dot(const FoamPoint &a, const FoamPoint &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+//! \return The average of pts[ndx[0 .. cnt)].
+static FoamPoint
+centre(const PointArray1 &pts, const FOAM_UINT32 *ndx, FOAM_UINT32 cnt)
+{
+    FoamPoint ret = { 0.0, 0.0, 0.0 };
+    for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+        ret.x += pts[ndx[ii]].x / cnt;
+        ret.y += pts[ndx[ii]].y / cnt;
+        ret.z += pts[ndx[ii]].z / cnt;
+    }
+    return ret;
+}
+
+
+//! \return The Newell normal of the polygon pts[ndx[0 .. cnt)].
+static FoamPoint
+normal(const PointArray1 &pts, const FOAM_UINT32 *ndx, FOAM_UINT32 cnt)
+{
+    FoamPoint ret = { 0.0, 0.0, 0.0 };
+    for (FOAM_UINT32 ii = 0; ii < cnt; ++ii) {
+        const FoamPoint &a = pts[ndx[ii]];
+        const FoamPoint &b = pts[ndx[(ii + 1) % cnt]];
+        ret.x += (a.y - b.y) * (a.z + b.z);
+        ret.y += (a.z - b.z) * (a.x + b.x);
+        ret.z += (a.x - b.x) * (a.y + b.y);
+    }
+    return ret;
+}
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A block mesh of n^3 hex cells, or of 6 tets per hex, in polyMesh form.
+
+    The interior faces are in upper triangular order and point out of their
+    owner, as OpenFOAM writes them. One extra point is not used by any face.
+*/
+struct TestMesh {
+
+    //! The file formats of writeCollated()
+    enum Format {
+        AsciiFaceList,  //!< ascii with the faces as a faceList
+        AsciiCompact,   //!< ascii with the faces as a faceCompactList
+        Binary32,       //!< binary with 32 bit labels
+        Binary64        //!< binary with 64 bit labels
+    };
+
+    TestMesh(FOAM_UINT32 n, bool tets) :
+        pts(),
+        cellCentres(),
+        faces(),
+        owner(),
+        neighbor(),
+        numInternal(0)
+    {
+        const FOAM_UINT32 np = n + 1;
+        for (FOAM_UINT32 kk = 0; kk < np; ++kk) {
+            for (FOAM_UINT32 jj = 0; jj < np; ++jj) {
+                for (FOAM_UINT32 ii = 0; ii < np; ++ii) {
+                    FoamPoint pt = { double(ii), double(jj), double(kk) };
+                    pts.push_back(pt);
+                }
+            }
+        }
+        // The unused point
+        FoamPoint far = { -10.0, -10.0, -10.0 };
+        pts.push_back(far);
+        UInt32Array2 cells;
+        for (FOAM_UINT32 kk = 0; kk < n; ++kk) {
+            for (FOAM_UINT32 jj = 0; jj < n; ++jj) {
+                for (FOAM_UINT32 ii = 0; ii < n; ++ii) {
+                    // The hex corner v[b] is offset by bit 0 in i, 1 in j
+                    // and 2 in k
+                    FOAM_UINT32 v[8];
+                    for (FOAM_UINT32 bb = 0; bb < 8; ++bb) {
+                        v[bb] = (ii + (bb & 1)) + np * ((jj + ((bb >> 1) & 1))
+                            + np * (kk + ((bb >> 2) & 1)));
+                    }
+                    addCell(v, tets, cells);
+                }
+            }
+        }
+        buildFaces(cells);
+    }
+
+
+    //! Adds the hex v or its 6 Kuhn tets. Each cell is a list of faces.
+    void
+    addCell(const FOAM_UINT32 v[8], bool tets, UInt32Array2 &cells)
+    {
+        if (!tets) {
+            const FOAM_UINT32 quads[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 },
+                { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 },
+                { 1, 3, 7, 5 } };
+            UInt32Array1 cell;
+            for (FOAM_UINT32 ff = 0; ff < 6; ++ff) {
+                for (FOAM_UINT32 jj = 0; jj < 4; ++jj) {
+                    cell.push_back(v[quads[ff][jj]]);
+                }
+            }
+            cells.push_back(cell);
+            return;
+        }
+        // Each tet walks from corner 0 to corner 7 one axis at a time
+        const FOAM_UINT32 axes[6][3] = { { 1, 2, 4 }, { 1, 4, 2 },
+            { 2, 1, 4 }, { 2, 4, 1 }, { 4, 1, 2 }, { 4, 2, 1 } };
+        for (FOAM_UINT32 tt = 0; tt < 6; ++tt) {
+            const FOAM_UINT32 t[4] = { v[0], v[axes[tt][0]],
+                v[axes[tt][0] | axes[tt][1]], v[7] };
+            UInt32Array1 cell;
+            for (FOAM_UINT32 ff = 0; ff < 4; ++ff) {
+                for (FOAM_UINT32 jj = 0; jj < 4; ++jj) {
+                    if (jj != ff) {
+                        cell.push_back(t[jj]);
+                    }
+                }
+            }
+            cells.push_back(cell);
+        }
+    }
+
+
+    //! Merges the shared cell faces and orders them like OpenFOAM.
+    void
+    buildFaces(const UInt32Array2 &cells)
+    {
+        // The sorted face verts -> the first cell and its oriented face
+        typedef std::map<UInt32Array1, std::pair<FOAM_UINT32, UInt32Array1> >
+            FaceMap;
+        FaceMap faceMap;
+        std::vector<std::pair<std::pair<FOAM_UINT32, FOAM_UINT32>,
+            UInt32Array1> > internal;
+        std::vector<std::pair<FOAM_UINT32, UInt32Array1> > bndry;
+        for (FOAM_UINT32 cc = 0; cc < cells.size(); ++cc) {
+            const UInt32Array1 &cell = cells[cc];
+            const FOAM_UINT32 vertCnt = (24 == cell.size()) ? 4 : 3;
+            cellCentres.push_back(centre(pts, &cell[0],
+                static_cast<FOAM_UINT32>(cell.size())));
+            for (size_t ff = 0; ff < cell.size(); ff += vertCnt) {
+                UInt32Array1 face(&cell[ff], &cell[ff] + vertCnt);
+                // Point the face out of cell cc
+                if (0.0 > dot(normal(pts, &face[0], vertCnt), sub(centre(pts,
+                        &face[0], vertCnt), cellCentres[cc]))) {
+                    std::reverse(face.begin() + 1, face.end());
+                }
+                UInt32Array1 key(face);
+                std::sort(key.begin(), key.end());
+                FaceMap::iterator it = faceMap.find(key);
+                if (faceMap.end() == it) {
+                    faceMap[key] = std::make_pair(cc, face);
+                }
+                else {
+                    // The lower cell is the owner. Its copy points out of it.
+                    internal.push_back(std::make_pair(std::make_pair(
+                        it->second.first, cc), it->second.second));
+                    faceMap.erase(it);
+                }
+            }
+        }
+        for (FaceMap::iterator it = faceMap.begin(); it != faceMap.end();
+                ++it) {
+            bndry.push_back(it->second);
+        }
+        std::sort(internal.begin(), internal.end());
+        std::stable_sort(bndry.begin(), bndry.end(), lessOwner);
+        numInternal = static_cast<FOAM_UINT32>(internal.size());
+        for (size_t ii = 0; ii < internal.size(); ++ii) {
+            faces.push_back(internal[ii].second);
+            owner.push_back(internal[ii].first.first);
+            neighbor.push_back(internal[ii].first.second);
+        }
+        for (size_t ii = 0; ii < bndry.size(); ++ii) {
+            faces.push_back(bndry[ii].second);
+            owner.push_back(bndry[ii].first);
+        }
+    }
+
+
+    static bool
+    lessOwner(const std::pair<FOAM_UINT32, UInt32Array1> &a,
+        const std::pair<FOAM_UINT32, UInt32Array1> &b)
+    {
+        return a.first < b.first;
+    }
+
+
+    static std::string
+    header(const char *cls, const char *obj, const std::string &note,
+        Format fmt = AsciiFaceList)
+    {
+        // Binary data has the byte order of this machine
+        const FOAM_UINT32 one = 1;
+        const bool isLsb = (1 == *reinterpret_cast<const unsigned char*>(&one));
+        const std::string format(isBinary(fmt) ?
+            std::string("binary;\n    arch        \"") +
+                (isLsb ? "LSB" : "MSB") + ";label=" +
+                ((Binary64 == fmt) ? "64" : "32") + ";scalar=64\"" : "ascii");
+        return std::string("FoamFile\n{\n    version     2.0;\n"
+            "    format      ") + format + ";\n    class       " + cls + ";\n" +
+            (note.empty() ? std::string() : "    note        \"" + note +
+                "\";\n") + "    location    \"constant/polyMesh\";\n"
+            "    object      " + obj + ";\n}\n"
+            "// * * * * * * * * * * * * * * * * * * * * //\n\n";
+    }
+
+
+    //! \return The counts note of the owner and neighbour headers.
+    std::string
+    note() const
+    {
+        char buf[128];
+        std::sprintf(buf, "nPoints:%lu  nCells:%lu  nFaces:%lu  "
+            "nInternalFaces:%lu", static_cast<unsigned long>(pts.size()),
+            static_cast<unsigned long>(cellCentres.size()),
+            static_cast<unsigned long>(faces.size()),
+            static_cast<unsigned long>(numInternal));
+        return buf;
+    }
+
+
+    //! Writes the points, faces, owner, neighbour and boundary files to the
+    //! cwd. All boundary faces are in the walls patch.
+    bool
+    write() const
+    {
+        const std::string note(this->note());
+        char buf[128];
+        std::sprintf(buf, "1\n(\n    walls\n    {\n        type wall;\n"
+            "        nFaces %lu;\n        startFace %lu;\n    }\n)\n",
+            static_cast<unsigned long>(faces.size() - numInternal),
+            static_cast<unsigned long>(numInternal));
+        bool ret = writeFile("boundary", header("polyBoundaryMesh",
+            "boundary", "") + buf);
+        ret = writeFile("points", header("vectorField", "points", "") +
+            pointsText(pts)) && ret;
+        ret = writeFile("faces", header("faceList", "faces", "") +
+            facesText(faces)) && ret;
+        ret = writeFile("owner", header("labelList", "owner", note) +
+            labelsText(owner)) && ret;
+        return writeFile("neighbour", header("labelList", "neighbour", note) +
+            labelsText(neighbor)) && ret;
+    }
+
+
+    /*! Writes the mesh decomposed into 2 ranks in the collated format to
+        the cwd. The lower half of the cells is rank 0. Each interior face
+        between the ranks is a boundary face of both. Rank 1 holds it
+        flipped, with a negative face address. If firstAddr is not 0, it
+        replaces the address of the first face of rank 1.
+    */
+    bool
+    writeCollated(Format fmt = AsciiFaceList, FOAM_INT64 firstAddr = 0) const
+    {
+        const FOAM_UINT32 NumRanks = 2;
+        const FOAM_UINT32 numCells =
+            static_cast<FOAM_UINT32>(cellCentres.size());
+        const char *names[] = { "points", "faces", "owner", "neighbour",
+            "pointProcAddressing", "faceProcAddressing", "cellProcAddressing" };
+        const char *classes[] = { "vectorField", (AsciiFaceList == fmt) ?
+            "faceList" : "faceCompactList", "labelList", "labelList",
+            "labelList", "labelList", "labelList" };
+        const size_t NumFiles = 7;
+        std::vector<std::string> blocks[NumFiles];
+        for (FOAM_UINT32 rank = 0; rank < NumRanks; ++rank) {
+            // The local cell of each global cell of the rank
+            UInt32Array1 cellAddr;
+            std::map<FOAM_UINT32, FOAM_UINT32> localCell;
+            for (FOAM_UINT32 cc = 0; cc < numCells; ++cc) {
+                if (rank == getRank(cc)) {
+                    localCell[cc] = static_cast<FOAM_UINT32>(cellAddr.size());
+                    cellAddr.push_back(cc);
+                }
+            }
+            // The rank's interior faces, then its boundary faces and then
+            // its faces on the other rank
+            UInt32Array1 order[3];
+            for (FOAM_UINT32 ff = 0; ff < faces.size(); ++ff) {
+                const bool ownIn = (rank == getRank(owner[ff]));
+                const bool nbrIn = (ff < numInternal) &&
+                    (rank == getRank(neighbor[ff]));
+                if (ownIn && nbrIn) {
+                    order[0].push_back(ff);
+                }
+                else if (ownIn && (ff >= numInternal)) {
+                    order[1].push_back(ff);
+                }
+                else if (ownIn || nbrIn) {
+                    order[2].push_back(ff);
+                }
+            }
+            UInt32Array2 lfaces;
+            UInt32Array1 lowner;
+            UInt32Array1 lnbr;
+            std::vector<FOAM_INT64> faceAddr;
+            UInt32Array1 pointAddr;
+            std::map<FOAM_UINT32, FOAM_UINT32> localPt;
+            for (FOAM_UINT32 kk = 0; kk < 3; ++kk) {
+                for (size_t ii = 0; ii < order[kk].size(); ++ii) {
+                    const FOAM_UINT32 ff = order[kk][ii];
+                    UInt32Array1 face(faces[ff]);
+                    FOAM_INT32 addr = static_cast<FOAM_INT32>(ff + 1);
+                    FOAM_UINT32 own = owner[ff];
+                    if (rank != getRank(own)) {
+                        // The face must point out of the local owner
+                        own = neighbor[ff];
+                        std::reverse(face.begin() + 1, face.end());
+                        addr = -addr;
+                    }
+                    for (size_t jj = 0; jj < face.size(); ++jj) {
+                        if (localPt.end() == localPt.find(face[jj])) {
+                            localPt[face[jj]] =
+                                static_cast<FOAM_UINT32>(pointAddr.size());
+                            pointAddr.push_back(face[jj]);
+                        }
+                        face[jj] = localPt[face[jj]];
+                    }
+                    lfaces.push_back(face);
+                    lowner.push_back(localCell[own]);
+                    if (0 == kk) {
+                        lnbr.push_back(localCell[neighbor[ff]]);
+                    }
+                    faceAddr.push_back(addr);
+                }
+            }
+            PointArray1 lpts;
+            for (size_t ii = 0; ii < pointAddr.size(); ++ii) {
+                lpts.push_back(pts[pointAddr[ii]]);
+            }
+            if ((0 != firstAddr) && (0 != rank)) {
+                faceAddr[0] = firstAddr;
+            }
+            blocks[0].push_back(pointsText(lpts, fmt));
+            blocks[1].push_back((AsciiFaceList == fmt) ? facesText(lfaces) :
+                compactText(lfaces, fmt));
+            blocks[2].push_back(listText(lowner, fmt));
+            blocks[3].push_back(listText(lnbr, fmt));
+            blocks[4].push_back(listText(pointAddr, fmt));
+            blocks[5].push_back(listText(faceAddr, fmt));
+            blocks[6].push_back(listText(cellAddr, fmt));
+        }
+        bool ret = true;
+        for (size_t ii = 0; ii < NumFiles; ++ii) {
+            std::string data(header("decomposedBlockData", names[ii], "",
+                fmt));
+            for (FOAM_UINT32 rank = 0; rank < NumRanks; ++rank) {
+                // The first block repeats the uncollated header
+                const std::string blk = ((0 == rank) ?
+                    header(classes[ii], names[ii], "", fmt) : std::string()) +
+                    blocks[ii][rank];
+                char buf[64];
+                std::sprintf(buf, "// Processor%lu\n%lu\n(",
+                    static_cast<unsigned long>(rank),
+                    static_cast<unsigned long>(blk.size()));
+                data += buf + blk + ")\n";
+            }
+            ret = writeFile(names[ii], data) && ret;
+        }
+        return ret;
+    }
+
+
+    //! \return The collated rank of cell.
+    FOAM_UINT32
+    getRank(FOAM_UINT32 cell) const
+    {
+        return (2 * cell < cellCentres.size()) ? 0 : 1;
+    }
+
+
+    //! \return true if fmt is a binary format.
+    static bool
+    isBinary(Format fmt)
+    {
+        return (Binary32 == fmt) || (Binary64 == fmt);
+    }
+
+
+    //! \return pts as the text of a vectorField in fmt.
+    static std::string
+    pointsText(const PointArray1 &pts, Format fmt = AsciiFaceList)
+    {
+        char buf[128];
+        std::sprintf(buf, "%lu\n(\n", static_cast<unsigned long>(pts.size()));
+        std::string data(buf);
+        if (isBinary(fmt)) {
+            // The raw data follows the ( directly
+            data.erase(data.size() - 1);
+            for (size_t ii = 0; ii < pts.size(); ++ii) {
+                const double xyz[3] = { pts[ii].x, pts[ii].y, pts[ii].z };
+                data.append(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+            }
+            return data + ")\n";
+        }
+        for (size_t ii = 0; ii < pts.size(); ++ii) {
+            std::sprintf(buf, "(%g %g %g)\n", pts[ii].x, pts[ii].y,
+                pts[ii].z);
+            data += buf;
+        }
+        return data + ")\n";
+    }
+
+
+    //! \return faces as the text of a faceList.
+    static std::string
+    facesText(const UInt32Array2 &faces)
+    {
+        char buf[32];
+        std::sprintf(buf, "%lu\n(\n", static_cast<unsigned long>(faces.size()));
+        std::string data(buf);
+        for (size_t ii = 0; ii < faces.size(); ++ii) {
+            std::sprintf(buf, "%lu(", static_cast<unsigned long>(
+                faces[ii].size()));
+            data += buf;
+            for (size_t jj = 0; jj < faces[ii].size(); ++jj) {
+                std::sprintf(buf, (0 == jj) ? "%lu" : " %lu",
+                    static_cast<unsigned long>(faces[ii][jj]));
+                data += buf;
+            }
+            data += ")\n";
+        }
+        return data + ")\n";
+    }
+
+
+    //! \return faces as the offsets and vertices lists of a faceCompactList
+    //! in fmt.
+    static std::string
+    compactText(const UInt32Array2 &faces, Format fmt)
+    {
+        UInt32Array1 offsets(1, 0);
+        UInt32Array1 verts;
+        for (size_t ii = 0; ii < faces.size(); ++ii) {
+            verts.insert(verts.end(), faces[ii].begin(), faces[ii].end());
+            offsets.push_back(static_cast<FOAM_UINT32>(verts.size()));
+        }
+        return listText(offsets, fmt) + listText(verts, fmt);
+    }
+
+
+    //! \return lbls as the text of a labelList in fmt.
+    template<typename T>
+    static std::string
+    listText(const std::vector<T> &lbls, Format fmt)
+    {
+        if (!isBinary(fmt)) {
+            return labelsText(lbls);
+        }
+        char buf[32];
+        std::sprintf(buf, "%lu\n(", static_cast<unsigned long>(lbls.size()));
+        std::string data(buf);
+        for (size_t ii = 0; ii < lbls.size(); ++ii) {
+            const FOAM_INT64 val64 = static_cast<FOAM_INT64>(lbls[ii]);
+            const FOAM_INT32 val32 = static_cast<FOAM_INT32>(lbls[ii]);
+            if (Binary64 == fmt) {
+                data.append(reinterpret_cast<const char*>(&val64), 8);
+            }
+            else {
+                data.append(reinterpret_cast<const char*>(&val32), 4);
+            }
+        }
+        return data + ")\n";
+    }
+
+
+    //! \return lbls as the text of a labelList.
+    template<typename T>
+    static std::string
+    labelsText(const std::vector<T> &lbls)
+    {
+        char buf[32];
+        std::sprintf(buf, "%lu\n(\n", static_cast<unsigned long>(lbls.size()));
+        std::string data(buf);
+        for (size_t ii = 0; ii < lbls.size(); ++ii) {
+            std::sprintf(buf, "%ld\n", static_cast<long>(lbls[ii]));
+            data += buf;
+        }
+        return data + ")\n";
+    }
+
+
+    static bool
+    writeFile(const char *name, const std::string &data)
+    {
+        FILE *fp = std::fopen(name, "wb");
+        bool ret = (0 != fp);
+        if (ret) {
+            ret = (data.size() == std::fwrite(data.data(), 1, data.size(), fp));
+            ret = (0 == std::fclose(fp)) && ret;
+        }
+        return ret;
+    }
+
+
+    PointArray1     pts;            //!< The points
+    PointArray1     cellCentres;    //!< The cell vertex averages
+    UInt32Array2    faces;          //!< The faces. Point out of the owner.
+    UInt32Array1    owner;          //!< The owner of each face
+    UInt32Array1    neighbor;       //!< The neighbour of each interior face
+    FOAM_UINT32     numInternal;    //!< The number of interior faces
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+/*! A PolyMeshHandler that keeps the mesh and checks it at endFaces().
+
+    The handler does not know the reader's cell numbering, so each pushed
+    face is matched to the generated faces by its sorted point coordinates.
+*/
+class MockHandler : public PolyMeshHandler {
+public:
+
+    MockHandler(const TestMesh &mesh) :
+        mesh_(mesh),
+        pts_(),
+        numPtsSet_(0),
+        faceCnt_(mesh.cellCentres.size(), 0),
+        numFaces_(0),
+        numSteps_(0),
+        inStep_(false),
+        abortAfter_(FOAM_UINT32_MAX),
+        numPolls_(0),
+        error_()
+    {
+    }
+
+
+    //! Makes isAborted() return true after it returned false cnt times.
+    inline void                 setAbortAfter(FOAM_UINT32 cnt) {
+                                    abortAfter_ = cnt; }
+
+    //! \return true if isAborted() returned true.
+    inline bool                 wasAborted() const {
+                                    return numPolls_ > abortAfter_; }
+
+
+    //! \return The first error or an empty string.
+    inline const std::string &  getError() const {
+                                    return error_; }
+
+    //! \return The number of points received.
+    inline FOAM_UINT32          getNumPts() const {
+                                    return numPtsSet_; }
+
+
+    virtual bool
+    beginRead(FOAM_UINT32 numSteps)
+    {
+        numSteps_ = numSteps;
+        return check(0 != numSteps, "no steps");
+    }
+
+
+    virtual bool
+    beginStep(FOAM_UINT32)
+    {
+        const bool ret = check(!inStep_ && (0 < numSteps_),
+            "unbalanced beginStep");
+        inStep_ = true;
+        --numSteps_;
+        return ret;
+    }
+
+
+    virtual bool
+    stepIncr(FOAM_UINT32)
+    {
+        return check(inStep_, "stepIncr outside a step");
+    }
+
+
+    virtual bool
+    endStep()
+    {
+        const bool ret = check(inStep_, "unbalanced endStep");
+        inStep_ = false;
+        return ret;
+    }
+
+
+    virtual bool
+    isAborted()
+    {
+        return abortAfter_ < ++numPolls_;
+    }
+
+
+    virtual bool
+    beginPoints(FOAM_UINT32 numPts)
+    {
+        pts_.assign(numPts, mesh_.pts.back());
+        return check(inStep_, "points outside a step");
+    }
+
+
+    virtual bool
+    pushPoints(FOAM_UINT32 first, const FoamPoint *pts, FOAM_UINT32 cnt)
+    {
+        bool ret = check(static_cast<size_t>(first) + cnt <= pts_.size(),
+            "point out of range");
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            pts_[first + ii] = pts[ii];
+        }
+        numPtsSet_ += ret ? cnt : 0;
+        return ret;
+    }
+
+
+    virtual bool
+    endPoints()
+    {
+        return check(numPtsSet_ == pts_.size(), "missing points");
+    }
+
+
+    virtual bool
+    beginFaces(FOAM_UINT32 numFaces)
+    {
+        return check(inStep_ && (mesh_.faces.size() == numFaces),
+            "wrong face count");
+    }
+
+
+    virtual bool
+    pushFaces(const FoamFace *faces, FOAM_UINT32 cnt)
+    {
+        bool ret = check(cnt <= BatchSize, "batch too large");
+        for (FOAM_UINT32 ii = 0; ii < cnt && ret; ++ii) {
+            ret = checkFace(faces[ii]);
+        }
+        return ret;
+    }
+
+
+    virtual bool
+    endFaces()
+    {
+        // A hex has 6 faces and a tet has 4
+        const FOAM_UINT32 expected = (4 == mesh_.faces[0].size()) ? 6 : 4;
+        bool ret = check(numFaces_ == mesh_.faces.size(), "missing faces");
+        for (size_t cc = 0; cc < faceCnt_.size() && ret; ++cc) {
+            ret = check(expected == faceCnt_[cc], "cell is not closed");
+        }
+        return ret;
+    }
+
+private:
+
+    //! Checks that face is oriented into its owner and counts its cells.
+    bool
+    checkFace(const FoamFace &face)
+    {
+        bool ret = check(((3 == face.vertCnt) || (4 == face.vertCnt)) &&
+            (face.owner < faceCnt_.size()), "bad face");
+        for (FOAM_UINT32 jj = 0; jj < face.vertCnt && ret; ++jj) {
+            ret = check(face.index[jj] < pts_.size(), "bad face point");
+        }
+        const bool isInterior = (FOAM_FACETYPE_INTERIOR == face.type);
+        ret = ret && check(!isInterior || (face.neighbor < faceCnt_.size()),
+            "bad neighbor");
+        // The id is the face's index in the faces file. The cells of an
+        // interior face are swapped by orientFace().
+        ret = ret && check((face.id < mesh_.owner.size()) &&
+            (isInterior == (face.id < mesh_.numInternal)) &&
+            (isInterior ? ((face.owner == mesh_.neighbor[face.id]) &&
+                (face.neighbor == mesh_.owner[face.id])) :
+                (face.owner == mesh_.owner[face.id])), "bad face id");
+        if (ret) {
+            // The reader may renumber the points but not the cells
+            const FoamPoint nrm = normal(pts_, face.index, face.vertCnt);
+            const FoamPoint ctr = centre(pts_, face.index, face.vertCnt);
+            ret = check(0.0 < dot(nrm, sub(mesh_.cellCentres[face.owner],
+                ctr)), "face points out of its owner") &&
+                check(!isInterior || (0.0 > dot(nrm, sub(
+                    mesh_.cellCentres[face.neighbor], ctr))),
+                    "face points into its neighbor");
+            ++faceCnt_[face.owner];
+            if (isInterior) {
+                ++faceCnt_[face.neighbor];
+            }
+            ++numFaces_;
+        }
+        return ret;
+    }
+
+
+    bool
+    check(bool cond, const char *msg)
+    {
+        if (!cond && error_.empty()) {
+            error_ = msg;
+        }
+        return cond;
+    }
+
+private:
+    MockHandler(const MockHandler&);
+    const MockHandler& operator=(const MockHandler&);
+
+private:
+    const TestMesh &    mesh_;      //!< The generated mesh
+    PointArray1         pts_;       //!< The received points
+    FOAM_UINT32         numPtsSet_; //!< The number of received points
+    UInt32Array1        faceCnt_;   //!< The faces received by each cell
+    FOAM_UINT32         numFaces_;  //!< The number of received faces
+    FOAM_UINT32         numSteps_;  //!< The steps not yet begun
+    bool                inStep_;    //!< true between beginStep and endStep
+    FOAM_UINT32         abortAfter_; //!< The polls before the abort
+    FOAM_UINT32         numPolls_;  //!< The isAborted() calls
+    std::string         error_;     //!< The first failed check
+};
+
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+
+//! Reads the mesh in the cwd with options. Prints and counts failures.
+static void
+runCase(const char *name, const TestMesh &mesh, const ImportOptions &options,
+    FoamTaskPool *pool, FOAM_UINT32 &numFailed)
+{
+    MockHandler handler(mesh);
+    PolyMeshReader reader(options, pool);
+    bool ret = reader.read(handler);
+    const FOAM_UINT32 numPts = static_cast<FOAM_UINT32>(mesh.pts.size()) -
+        (options.compactPoints ? 1 : 0);
+    ret = ret && handler.getError().empty() &&
+        (numPts == handler.getNumPts());
+    std::printf("%-4s %-24s %s %s\n", mesh.faces[0].size() == 4 ? "hex" :
+        "tet", name, ret ? "ok" : "FAILED", handler.getError().c_str());
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! Cancels the read after 0, 1, 2 ... polls of the handler until a read
+//! completes without being cancelled. Each cancelled read must fail
+//! cleanly and the completed read must be correct. Prints and counts
+//! failures.
+static void
+checkCancel(const char *name, const TestMesh &mesh,
+    const ImportOptions &options, FoamTaskPool *pool, FOAM_UINT32 &numFailed)
+{
+    bool ret = false;
+    bool done = false;
+    FOAM_UINT32 numCancelled = 0;
+    for (FOAM_UINT32 cnt = 0; (cnt < 1000) && !done; ++cnt) {
+        MockHandler handler(mesh);
+        handler.setAbortAfter(cnt);
+        PolyMeshReader reader(options, pool);
+        const bool readOk = reader.read(handler);
+        done = !handler.wasAborted();
+        ret = done ? (readOk && handler.getError().empty()) : !readOk;
+        numCancelled += done ? 0 : 1;
+        done = done || !ret;
+    }
+    // The stage must poll at least once
+    ret = ret && (0 < numCancelled);
+    std::printf("%-4s %-24s %s\n", mesh.faces[0].size() == 4 ? "hex" :
+        "tet", name, ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! Builds the cell to face adjacency on 4 threads with small ranges and
+//! compares it to a serial build. Prints and counts failures.
+static void
+checkCsr(const TestMesh &mesh, FOAM_UINT32 &numFailed)
+{
+    FoamTaskPool pool(4);
+    pool.setGrains("adjacency=64");
+    FoamTaskScope scope(&pool, FoamTaskPool::PollFunc());
+    FoamLabelArray1 owners(mesh.owner.begin(), mesh.owner.end());
+    FoamLabelArray1 neighbors(mesh.neighbor.begin(), mesh.neighbor.end());
+    CellFaceCsr csr;
+    bool ret = csr.build(owners, neighbors) &&
+        (mesh.cellCentres.size() == csr.getNumCells());
+    UInt32Array2 cellFaces(mesh.cellCentres.size());
+    for (FOAM_UINT32 ff = 0; ff < owners.size(); ++ff) {
+        cellFaces[owners[ff]].push_back(ff);
+        if (ff < neighbors.size()) {
+            cellFaces[neighbors[ff]].push_back(ff);
+        }
+    }
+    for (FOAM_UINT32 cc = 0; cc < cellFaces.size() && ret; ++cc) {
+        const UInt32Array1 &faces = cellFaces[cc];
+        ret = (faces.size() == csr.getEnd(cc) - csr.getBegin(cc));
+        for (FOAM_UINT32 kk = 0; kk < faces.size() && ret; ++kk) {
+            ret = (faces[kk] == csr.getFace(csr.getBegin(cc) + kk));
+        }
+    }
+    {
+        // A cancelled build fails and leaves no adjacency
+        FoamTaskScope cancel(&pool, []() { return false; });
+        ret = ret && !csr.build(owners, neighbors) &&
+            (0 == csr.getNumCells());
+    }
+    // A cell count too large for 32 bit labels
+    owners[0] = FOAM_UINT32_MAX - 1;
+    ret = ret && !csr.build(owners, neighbors);
+    std::printf("%-4s %-24s %s\n", mesh.faces[0].size() == 4 ? "hex" :
+        "tet", "adjacency", ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! Marks the used points of the faces on 4 threads with small ranges. All
+//! points but the unused one must be marked. Prints and counts failures.
+static void
+checkCompactor(const TestMesh &mesh, FOAM_UINT32 &numFailed)
+{
+    FoamTaskPool pool(4);
+    pool.setGrains("compact=64");
+    FoamTaskScope scope(&pool, FoamTaskPool::PollFunc());
+    std::vector<FoamFace> faces(mesh.faces.size());
+    for (FOAM_UINT32 ff = 0; ff < faces.size(); ++ff) {
+        FoamFace &face = faces[ff];
+        face.vertCnt = static_cast<FOAM_UINT32>(mesh.faces[ff].size());
+        std::copy(mesh.faces[ff].begin(), mesh.faces[ff].end(), face.index);
+    }
+    const FOAM_UINT32 numPts = static_cast<FOAM_UINT32>(mesh.pts.size());
+    MockHandler handler(mesh);
+    PointCompactor compactor(handler);
+    compactor.beginMark(numPts);
+    bool ret = true;
+    for (FOAM_UINT32 ff = 0; ff < faces.size() && ret; ff += 1000) {
+        const FOAM_UINT32 cnt = std::min<FOAM_UINT32>(1000,
+            static_cast<FOAM_UINT32>(faces.size()) - ff);
+        ret = compactor.markFaces(&faces[ff], cnt);
+    }
+    ret = ret && compactor.endMark() &&
+        (numPts - 1 == compactor.getNumUsed());
+    // A point index past the last point
+    faces.back().index[0] = numPts;
+    compactor.beginMark(numPts);
+    ret = ret && !compactor.markFaces(faces.data(),
+        static_cast<FOAM_UINT32>(faces.size()));
+    // No used point
+    compactor.beginMark(numPts);
+    ret = ret && !compactor.endMark() && (0 == compactor.getNumUsed()) &&
+        !compactor.beginPoints(numPts);
+    std::printf("%-4s %-24s %s\n", mesh.faces[0].size() == 4 ? "hex" :
+        "tet", "compactor", ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! \return A zones file of format holding the numZones entries in body.
+static std::string
+zonesText(const char *obj, const char *format, const char *labelBits,
+    FOAM_UINT32 numZones, const std::string &body)
+{
+    // Binary data has the byte order of this machine
+    const FOAM_UINT32 one = 1;
+    const bool isLsb = (1 == *reinterpret_cast<const unsigned char*>(&one));
+    char buf[32];
+    std::sprintf(buf, "%lu\n(\n", static_cast<unsigned long>(numZones));
+    return std::string("FoamFile\n{\n    version     2.0;\n"
+        "    format      ") + format + ";\n    arch        \"" +
+        (isLsb ? "LSB" : "MSB") + ";label=" + labelBits + ";scalar=64\";\n"
+        "    class       regIOobject;\n    object      " + obj + ";\n}\n" +
+        buf + body + ")\n";
+}
+
+
+//! \return vals as a binary list of T.
+template<typename T>
+static std::string
+binaryText(const std::vector<T> &vals)
+{
+    char buf[32];
+    std::sprintf(buf, "%lu(", static_cast<unsigned long>(vals.size()));
+    return buf + std::string(reinterpret_cast<const char*>(vals.data()),
+        vals.size() * sizeof(T)) + ")";
+}
+
+
+//! \return true if the zones in file name are read as expected. If labels
+//! is empty, the read must fail.
+static bool
+checkZoneFile(const char *name, FOAM_ZONETYPE type, const std::string &data,
+    const UInt32Array2 &labels, const UInt32Array2 &flips)
+{
+    FoamZoneArray1 zones;
+    ZoneListFile file(name, type);
+    bool ret = TestMesh::writeFile(name, data);
+    if (ret && labels.empty()) {
+        return !file.read(zones);
+    }
+    ret = ret && file.read(zones) && (labels.size() == zones.size());
+    for (size_t ii = 0; ii < zones.size() && ret; ++ii) {
+        const FoamZone &zone = zones[ii];
+        ret = (type == zone.type) && (labels[ii] == zone.labels) &&
+            (flips[ii].size() == zone.flips.size()) &&
+            std::equal(flips[ii].begin(), flips[ii].end(),
+                zone.flips.begin());
+    }
+    return ret;
+}
+
+
+//! Reads the mesh in the cwd with a zone file holding one zone of labels.
+//! \return true if the read result is expected.
+static bool
+checkZoneRange(const TestMesh &mesh, const char *name, const char *key,
+    FOAM_UINT32 label, bool expected)
+{
+    char body[128];
+    std::sprintf(body, "z\n{\n    %s List<label> 2(0 %lu);\n}\n", key,
+        static_cast<unsigned long>(label));
+    MockHandler handler(mesh);
+    PolyMeshReader reader(ImportOptions(), 0);
+    bool ret = TestMesh::writeFile(name, zonesText(name, "ascii", "32", 1,
+        body));
+    ret = ret && (expected == (reader.read(handler) &&
+        handler.getError().empty()));
+    std::remove(name);
+    return ret;
+}
+
+
+//! Reads zone files in each list format and checks that bad zones are
+//! rejected. Prints and counts failures.
+static void
+checkZones(const TestMesh &mesh, FOAM_UINT32 &numFailed)
+{
+    const char *mtype = (mesh.faces[0].size() == 4) ? "hex" : "tet";
+    const UInt32Array2 none;
+    UInt32Array2 noFlips(2);
+    // ascii, unsorted and uniform lists
+    const std::string ascii(zonesText("cellZones", "ascii", "32", 2,
+        "a\n{\n    type cellZone;\n    cellLabels List<label> 4(7 3 5 1);\n"
+        "}\n"
+        "b\n{\n    type cellZone;\n    cellLabels List<label> 1{2};\n}\n"));
+    UInt32Array2 labels(2);
+    labels[0] = { 1, 3, 5, 7 };
+    labels[1] = { 2 };
+    bool ret = checkZoneFile("cellZones", FOAM_ZONETYPE_CELL, ascii, labels,
+        noFlips);
+    // The flips are sorted with their labels. A uniform flipMap may come
+    // before the labels.
+    const std::string flipped(zonesText("faceZones", "ascii", "32", 2,
+        "f\n{\n    type faceZone;\n    faceLabels List<label> 3(9 2 5);\n"
+        "    flipMap List<bool> 3(1 0 1);\n}\n"
+        "g\n{\n    type faceZone;\n    flipMap List<bool> 2{1};\n"
+        "    faceLabels List<label> 2(4 1);\n}\n"));
+    UInt32Array2 flips(2);
+    labels[0] = { 2, 5, 9 };
+    flips[0] = { 0, 1, 1 };
+    labels[1] = { 1, 4 };
+    flips[1] = { 1, 1 };
+    ret = checkZoneFile("faceZones", FOAM_ZONETYPE_FACE, flipped, labels,
+        flips) && ret;
+    std::printf("%-4s %-24s %s\n", mtype, "zones ascii",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // binary lists of 32 and 64 bit labels and byte flags
+    const std::vector<FOAM_INT32> lbls32 = { 6, 2 };
+    const std::vector<FOAM_INT64> lbls64 = { 8, 4000000000LL };
+    const std::vector<unsigned char> bytes = { 1, 0 };
+    labels.assign(1, UInt32Array1{ 2, 6 });
+    flips.assign(1, UInt32Array1{ 0, 1 });
+    ret = checkZoneFile("faceZones", FOAM_ZONETYPE_FACE,
+        zonesText("faceZones", "binary", "32", 1, "f\n{\n    faceLabels "
+            "List<label> " + binaryText(lbls32) + ";\n    flipMap "
+            "List<bool> " + binaryText(bytes) + ";\n}\n"), labels, flips);
+    labels.assign(1, UInt32Array1{ 8, 4000000000U });
+    ret = checkZoneFile("pointZones", FOAM_ZONETYPE_POINT,
+        zonesText("pointZones", "binary", "64", 1, "p\n{\n    pointLabels "
+            "List<label> " + binaryText(lbls64) + ";\n}\n"), labels,
+        noFlips) && ret;
+    std::printf("%-4s %-24s %s\n", mtype, "zones binary",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // Counts that do not fit the file, repeated labels, negative labels and
+    // a flipMap that does not match the labels
+    const char *bad[] = {
+        "cellLabels List<label> 4000000000(1 2);",
+        "cellLabels List<label> 2{3};",
+        "cellLabels List<label> 1(3); flipMap List<bool> 4000000000{0};",
+        "flipMap List<bool> 4000000000{0}; cellLabels List<label> 1(3);",
+        "cellLabels List<label> 1(3); flipMap List<bool> 2(1 0);",
+        "cellLabels List<label> 2(3 -1);" };
+    ret = true;
+    for (size_t ii = 0; ii < sizeof(bad) / sizeof(bad[0]) && ret; ++ii) {
+        ret = checkZoneFile("cellZones", FOAM_ZONETYPE_CELL,
+            zonesText("cellZones", "ascii", "32", 1,
+                std::string("a\n{\n    ") + bad[ii] + "\n}\n"), none, none);
+    }
+    const std::vector<FOAM_INT32> negative = { 1, -1 };
+    ret = ret && checkZoneFile("cellZones", FOAM_ZONETYPE_CELL,
+        zonesText("cellZones", "binary", "32", 1, "a\n{\n    cellLabels "
+            "List<label> 1000" + binaryText(negative).substr(1) + ";\n}\n"),
+        none, none);
+    ret = ret && checkZoneFile("cellZones", FOAM_ZONETYPE_CELL,
+        zonesText("cellZones", "binary", "32", 1, "a\n{\n    cellLabels "
+            "List<label> " + binaryText(negative) + ";\n}\n"), none, none);
+    std::remove("cellZones");
+    std::remove("faceZones");
+    std::remove("pointZones");
+    std::printf("%-4s %-24s %s\n", mtype, "zones bad lists",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // The reader checks the labels against the mesh
+    const FOAM_UINT32 numCells = static_cast<FOAM_UINT32>(
+        mesh.cellCentres.size());
+    const FOAM_UINT32 numFaces = static_cast<FOAM_UINT32>(mesh.faces.size());
+    const FOAM_UINT32 numPts = static_cast<FOAM_UINT32>(mesh.pts.size());
+    ret = checkZoneRange(mesh, "cellZones", "cellLabels", numCells - 1,
+        true) && checkZoneRange(mesh, "cellZones", "cellLabels", numCells,
+        false) && checkZoneRange(mesh, "faceZones", "faceLabels",
+        numFaces - 1, true) && checkZoneRange(mesh, "faceZones",
+        "faceLabels", numFaces, false) && checkZoneRange(mesh, "pointZones",
+        "pointLabels", numPts - 1, true) && checkZoneRange(mesh,
+        "pointZones", "pointLabels", numPts, false);
+    std::printf("%-4s %-24s %s\n", mtype, "zones range",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! Reads the collated mesh in the cwd. The unused point is not in any
+//! rank, so it is dropped. \return true if the read result is expected.
+static bool
+checkCollatedRead(const TestMesh &mesh, FoamTaskPool *pool, bool expected)
+{
+    MockHandler handler(mesh);
+    PolyMeshReader reader(ImportOptions(), pool);
+    const bool ret = reader.read(handler) && handler.getError().empty() &&
+        (mesh.pts.size() - 1 == handler.getNumPts());
+    return expected == ret;
+}
+
+
+//! Writes data to file name and reads the mesh in the cwd with the prescan.
+//! A rejected read must fail before any point is read. The mesh files are
+//! restored. \return true if the read result is expected.
+static bool
+checkPrescanRead(const TestMesh &mesh, FoamTaskPool *pool, const char *name,
+    const std::string &data, bool expected)
+{
+    ImportOptions options;
+    options.prescan = true;
+    MockHandler handler(mesh);
+    PolyMeshReader reader(options, pool);
+    bool ret = TestMesh::writeFile(name, data);
+    const bool readOk = ret && reader.read(handler) &&
+        handler.getError().empty();
+    ret = ret && (expected == readOk) &&
+        (expected || (0 == handler.getNumPts()));
+    return mesh.write() && ret;
+}
+
+
+//! \return text with its leading list count replaced by cnt.
+static std::string
+withCount(const std::string &text, size_t cnt)
+{
+    char buf[32];
+    std::sprintf(buf, "%lu", static_cast<unsigned long>(cnt));
+    return buf + text.substr(text.find_first_not_of("0123456789"));
+}
+
+
+//! Corrupts each mesh file in turn. Each must be rejected by the prescan.
+//! A ")" in a comment after a list must not be counted. Prints and counts
+//! failures.
+static void
+checkPrescan(const TestMesh &mesh, FoamTaskPool *pool,
+    FOAM_UINT32 &numFailed)
+{
+    const char *mtype = (mesh.faces[0].size() == 4) ? "hex" : "tet";
+    const std::string ptsHdr(TestMesh::header("vectorField", "points", ""));
+    const std::string facesHdr(TestMesh::header("faceList", "faces", ""));
+    const std::string ownerHdr(TestMesh::header("labelList", "owner",
+        mesh.note()));
+    const std::string nborHdr(TestMesh::header("labelList", "neighbour",
+        mesh.note()));
+    const std::string faces(TestMesh::facesText(mesh.faces));
+    const std::string owner(TestMesh::labelsText(mesh.owner));
+    const std::string comments("// )\n/* ) */\n");
+    bool ret = checkPrescanRead(mesh, pool, "faces", facesHdr + faces +
+        comments, true) && checkPrescanRead(mesh, pool, "owner", ownerHdr +
+        owner + comments, true);
+    std::printf("%-4s %-24s %s\n", mtype, "prescan comments",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // Cut in a record and in the closing ")"
+    ret = checkPrescanRead(mesh, pool, "faces", facesHdr +
+            faces.substr(0, faces.size() / 2), false) &&
+        checkPrescanRead(mesh, pool, "points", ptsHdr +
+            TestMesh::pointsText(mesh.pts).substr(0, 200), false) &&
+        checkPrescanRead(mesh, pool, "owner", ownerHdr +
+            owner.substr(0, owner.size() / 2), false) &&
+        checkPrescanRead(mesh, pool, "neighbour", nborHdr +
+            TestMesh::labelsText(mesh.neighbor).substr(0, 40), false);
+    std::printf("%-4s %-24s %s\n", mtype, "prescan truncated",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // A record short with a ")" in a comment, a record too many, a label
+    // too many and a label that wraps a 64 bit accumulator to 0
+    UInt32Array2 fewerFaces(mesh.faces.begin(), mesh.faces.end() - 1);
+    PointArray1 morePts(mesh.pts);
+    morePts.push_back(mesh.pts[0]);
+    UInt32Array1 moreOwner(mesh.owner);
+    moreOwner.push_back(0);
+    const size_t first = owner.find("(\n") + 2;
+    ret = checkPrescanRead(mesh, pool, "faces", facesHdr +
+            withCount(TestMesh::facesText(fewerFaces), mesh.faces.size()) +
+            comments, false) &&
+        checkPrescanRead(mesh, pool, "points", ptsHdr +
+            withCount(TestMesh::pointsText(morePts), mesh.pts.size()), false) &&
+        checkPrescanRead(mesh, pool, "owner", ownerHdr +
+            withCount(TestMesh::labelsText(moreOwner), mesh.owner.size()),
+            false) &&
+        checkPrescanRead(mesh, pool, "owner", ownerHdr + owner.substr(0,
+            first) + "18446744073709551616" + owner.substr(owner.find('\n',
+            first)), false);
+    std::printf("%-4s %-24s %s\n", mtype, "prescan count mismatch",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // An owner and a neighbour label that is not a cell of nCells
+    UInt32Array1 badOwner(mesh.owner);
+    badOwner.back() = static_cast<FOAM_UINT32>(mesh.cellCentres.size());
+    UInt32Array1 badNbor(mesh.neighbor);
+    badNbor.back() = static_cast<FOAM_UINT32>(mesh.cellCentres.size());
+    ret = checkPrescanRead(mesh, pool, "owner", ownerHdr +
+            TestMesh::labelsText(badOwner), false) &&
+        checkPrescanRead(mesh, pool, "neighbour", nborHdr +
+            TestMesh::labelsText(badNbor), false);
+    std::printf("%-4s %-24s %s\n", mtype, "prescan bad cell",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! Reads the mesh from collated files in each format. Bad face addresses
+//! must be rejected. Prints and counts failures.
+static void
+checkCollated(const TestMesh &mesh, FoamTaskPool *pool,
+    FOAM_UINT32 &numFailed)
+{
+    const char *mtype = (mesh.faces[0].size() == 4) ? "hex" : "tet";
+    const char *names[] = { "collated ascii", "collated compact",
+        "collated binary", "collated binary 64" };
+    const TestMesh::Format fmts[] = { TestMesh::AsciiFaceList,
+        TestMesh::AsciiCompact, TestMesh::Binary32, TestMesh::Binary64 };
+    bool ret;
+    for (size_t ii = 0; ii < sizeof(fmts) / sizeof(fmts[0]); ++ii) {
+        ret = mesh.writeCollated(fmts[ii]) &&
+            checkCollatedRead(mesh, pool, true);
+        std::printf("%-4s %-24s %s\n", mtype, names[ii],
+            ret ? "ok" : "FAILED");
+        numFailed += ret ? 0 : 1;
+    }
+
+    // An address past the faces of all ranks, the smallest int that has
+    // no positive value and a 64 bit address too large for a face
+    ret = mesh.writeCollated(TestMesh::AsciiFaceList, 2000000000) &&
+        checkCollatedRead(mesh, pool, false) &&
+        mesh.writeCollated(TestMesh::Binary32, FOAM_INT64(-2147483647) - 1) &&
+        checkCollatedRead(mesh, pool, false) &&
+        mesh.writeCollated(TestMesh::Binary64, FOAM_INT64(1) << 32) &&
+        checkCollatedRead(mesh, pool, false);
+    std::printf("%-4s %-24s %s\n", mtype, "collated bad address",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! \return The contents of file name. Empty if it cannot be read.
+static std::string
+readFile(const char *name)
+{
+    std::string data;
+    FILE *fp = std::fopen(name, "rb");
+    if (0 != fp) {
+        char buf[4096];
+        size_t cnt;
+        while (0 < (cnt = std::fread(buf, 1, sizeof(buf), fp))) {
+            data.append(buf, cnt);
+        }
+        std::fclose(fp);
+    }
+    return data;
+}
+
+
+/*! \return A tar of the mesh files in the cwd in directory dir. If oldGnu
+    is true, the headers have the old GNU magic and a time where a ustar
+    header has its name prefix.
+*/
+static std::string
+tarText(const std::string &dir, bool oldGnu)
+{
+    const char *names[] = { "points", "faces", "owner", "neighbour",
+        "boundary" };
+    std::string tar;
+    for (size_t ii = 0; ii < sizeof(names) / sizeof(names[0]); ++ii) {
+        const std::string data(readFile(names[ii]));
+        std::string hdr(512, '\0');
+        hdr.replace(0, dir.size() + std::strlen(names[ii]), dir + names[ii]);
+        char buf[16];
+        std::sprintf(buf, "%011lo", static_cast<unsigned long>(data.size()));
+        hdr.replace(100, 7, "0000644");
+        hdr.replace(124, 11, buf);
+        hdr.replace(136, 11, "00000000000");
+        hdr[156] = '0';
+        if (oldGnu) {
+            hdr.replace(257, 8, "ustar  \0", 8);
+            hdr.replace(345, 11, "14000000000");
+        }
+        else {
+            hdr.replace(257, 8, "ustar\0" "00", 8);
+        }
+        // The checksum is summed with its own field set to spaces
+        hdr.replace(148, 8, 8, ' ');
+        unsigned long sum = 0;
+        for (size_t jj = 0; jj < hdr.size(); ++jj) {
+            sum += static_cast<unsigned char>(hdr[jj]);
+        }
+        std::sprintf(buf, "%06lo", sum);
+        hdr.replace(148, 7, buf, 7);
+        tar += hdr + data + std::string((512 - data.size() % 512) % 512, '\0');
+    }
+    // The two zero blocks that end the archive
+    return tar + std::string(1024, '\0');
+}
+
+
+#if defined(FOAM_HAVE_ZLIB)
+//! \return data compressed as one gzip stream.
+static std::string
+gzipText(const std::string &data)
+{
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    // 16 writes a gzip header
+    std::string ret;
+    if (Z_OK == deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+            15 + 16, 8, Z_DEFAULT_STRATEGY)) {
+        ret.resize(deflateBound(&strm, static_cast<uLong>(data.size())));
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(
+            data.data()));
+        strm.avail_in = static_cast<uInt>(data.size());
+        strm.next_out = reinterpret_cast<Bytef*>(&ret[0]);
+        strm.avail_out = static_cast<uInt>(ret.size());
+        const bool ok = (Z_STREAM_END == deflate(&strm, Z_FINISH));
+        ret.resize(ok ? strm.total_out : 0);
+        deflateEnd(&strm);
+    }
+    return ret;
+}
+#endif
+
+
+//! Reads the mesh from archive name holding data.
+//! \return true if the read result is expected.
+static bool
+checkArchiveRead(const TestMesh &mesh, const char *name,
+    const std::string &data, bool expected)
+{
+    ImportOptions options;
+    options.archive = name;
+    options.archiveMeshDir = "case/constant/polyMesh";
+    MockHandler handler(mesh);
+    PolyMeshReader reader(options, 0);
+    bool ret = TestMesh::writeFile(name, data);
+    ret = ret && (expected == (reader.read(handler) &&
+        handler.getError().empty()));
+    std::remove(name);
+    return ret;
+}
+
+
+//! Reads the mesh in the cwd from tar and compressed tar archives. The
+//! end blocks may be missing, but a truncated archive must be rejected.
+//! Prints and counts failures.
+static void
+checkArchive(const TestMesh &mesh, FOAM_UINT32 &numFailed)
+{
+    const char *mtype = (mesh.faces[0].size() == 4) ? "hex" : "tet";
+    const std::string tar(tarText("./case/constant/polyMesh/", false));
+    bool ret = checkArchiveRead(mesh, "mesh.tar", tar, true) &&
+        checkArchiveRead(mesh, "mesh.tar", tarText("case/constant/polyMesh/",
+            true), true) &&
+        checkArchiveRead(mesh, "mesh.tar", tar.substr(0, tar.size() - 1024),
+            true);
+    std::printf("%-4s %-24s %s\n", mtype, "archive tar",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // Cut in a member, in a header and in the end blocks
+    ret = checkArchiveRead(mesh, "mesh.tar", tar.substr(0, tar.size() / 2),
+        false) && checkArchiveRead(mesh, "mesh.tar",
+        tar.substr(0, tar.size() - 1024 - 300), false) &&
+        checkArchiveRead(mesh, "mesh.tar", tar.substr(0, tar.size() - 300),
+        false);
+    std::printf("%-4s %-24s %s\n", mtype, "archive truncated tar",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+#if defined(FOAM_HAVE_ZLIB)
+    const std::string gz(gzipText(tar));
+    ret = !gz.empty() && checkArchiveRead(mesh, "mesh.tar.gz", gz, true) &&
+        checkArchiveRead(mesh, "mesh.tar.gz", gz.substr(0, gz.size() / 2),
+            false) &&
+        checkArchiveRead(mesh, "mesh.tar.gz", gz.substr(0, gz.size() - 1),
+            false);
+    std::printf("%-4s %-24s %s\n", mtype, "archive tar.gz",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+#endif
+}
+
+
+//! \return true if info holds the counts and patch of mesh and storage.
+static bool
+probeOk(const TestMesh &mesh, const PolyMeshInfo &info, const char *storage)
+{
+    const FOAM_UINT32 numFaces = static_cast<FOAM_UINT32>(mesh.faces.size());
+    return (mesh.pts.size() == info.numPts) && (numFaces == info.numFaces) &&
+        (mesh.numInternal == info.numInternalFaces) &&
+        (mesh.cellCentres.size() == info.numCells) &&
+        (storage == info.storage) && ("faceList" == info.facesClass) &&
+        (1 == info.patches.size()) && ("walls" == info.patches[0].name) &&
+        ("wall" == info.patches[0].type) &&
+        (numFaces - mesh.numInternal == info.patches[0].nFaces) &&
+        (mesh.numInternal == info.patches[0].startFace);
+}
+
+
+//! Probes the mesh files in the cwd, with a quoted arch in the faces
+//! header, in a tar archive and as collated files. Prints and counts
+//! failures.
+static void
+checkProbe(const TestMesh &mesh, FOAM_UINT32 &numFailed)
+{
+    const char *mtype = (mesh.faces[0].size() == 4) ? "hex" : "tet";
+    PolyMeshInfo info;
+    bool ret = probePolyMesh("", info) && probeOk(mesh, info, "files") &&
+        ("ascii" == info.format) && (32 == info.labelBits) &&
+        (64 == info.scalarBits) && ("none" == info.compression);
+    std::printf("%-4s %-24s %s\n", mtype, "probe", ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    // The ; inside the quotes must not end the arch
+    const std::string faces(readFile("faces"));
+    std::string archFaces(faces);
+    archFaces.insert(archFaces.find("    class"),
+        "    arch        \"LSB;label=64;scalar=32\";\n");
+    ret = TestMesh::writeFile("faces", archFaces) &&
+        probePolyMesh(".", info) && probeOk(mesh, info, "files") &&
+        ("LSB;label=64;scalar=32" == info.arch) && (64 == info.labelBits) &&
+        (32 == info.scalarBits);
+    ret = TestMesh::writeFile("faces", faces) && ret;
+    std::printf("%-4s %-24s %s\n", mtype, "probe arch", ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    FoamArchive archive;
+    ret = TestMesh::writeFile("mesh.tar", tarText("case/constant/polyMesh/",
+        false)) && archive.open("mesh.tar") &&
+        probePolyMesh("ignored", info, &archive) &&
+        probeOk(mesh, info, "archive") && ("none" == info.compression);
+    archive.close();
+    std::remove("mesh.tar");
+    std::printf("%-4s %-24s %s\n", mtype, "probe archive",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+
+    ret = mesh.writeCollated() && probePolyMesh("", info) &&
+        ("collated" == info.storage) && (2 == info.numRanks) &&
+        ("ascii" == info.format) && (0 == info.numPts);
+    ret = mesh.write() && ret;
+    std::printf("%-4s %-24s %s\n", mtype, "probe collated",
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+//! \return true if val is within round off of the report's 6 digits of
+//! expected.
+static bool
+isNear(double val, double expected)
+{
+    return std::fabs(val - expected) <= 1e-5 * std::max(1.0,
+        std::fabs(expected));
+}
+
+
+//! Gets the value of the key line in section of a quality report and the
+//! face or cell in the parentheses after it. \return false if the line is
+//! missing.
+static bool
+reportVal(const std::string &report, const char *section, const char *key,
+    double &val, unsigned long &item)
+{
+    const std::string::size_type sec = report.find(std::string(section) +
+        "\n");
+    const std::string::size_type pos = (std::string::npos == sec) ? sec :
+        report.find(std::string("  ") + key + " ", sec);
+    char kind[8];
+    return (std::string::npos != pos) && (3 == std::sscanf(report.c_str() +
+        pos + 2 + std::strlen(key), " %lf (%7s %lu)", &val, kind, &item));
+}
+
+
+//! Computes the non-orthogonality and skewness of interior face ff. The
+//! cell and face centers of the hex and tet cells are vertex averages.
+static void
+faceMetrics(const TestMesh &mesh, size_t ff, double &nonOrtho, double &skew)
+{
+    const UInt32Array1 &face = mesh.faces[ff];
+    const FOAM_UINT32 cnt = static_cast<FOAM_UINT32>(face.size());
+    const FoamPoint n = normal(mesh.pts, &face[0], cnt);
+    const FoamPoint cf = centre(mesh.pts, &face[0], cnt);
+    const FoamPoint &co = mesh.cellCentres[mesh.owner[ff]];
+    const FoamPoint d = sub(mesh.cellCentres[mesh.neighbor[ff]], co);
+    const double dLen = std::sqrt(dot(d, d));
+    nonOrtho = std::acos(std::min(1.0, dot(d, n) / (dLen *
+        std::sqrt(dot(n, n))))) * 180.0 / std::acos(-1.0);
+    const double t = dot(sub(cf, co), n) / dot(d, n);
+    const FoamPoint e = { cf.x - co.x - t * d.x, cf.y - co.y - t * d.y,
+        cf.z - co.z - t * d.z };
+    skew = std::sqrt(dot(e, e)) / dLen;
+}
+
+
+//! Checks the max and the worst cell of a face metric in report against
+//! the metric of each interior face in vals.
+static bool
+checkWorst(const TestMesh &mesh, const std::string &report,
+    const char *section, const DoubleArray1 &vals)
+{
+    const double maxVal = *std::max_element(vals.begin(), vals.end());
+    double val;
+    unsigned long face;
+    unsigned long cell;
+    bool ret = reportVal(report, section, "max", val, face) &&
+        isNear(val, maxVal) && (face < vals.size()) &&
+        isNear(vals[face], maxVal) &&
+        reportVal(report, section, "worst cell", val, cell) &&
+        isNear(val, maxVal);
+    // The worst cell must be a cell of a worst face
+    bool found = false;
+    for (size_t ff = 0; ff < vals.size() && ret && !found; ++ff) {
+        found = isNear(vals[ff], maxVal) && ((cell == mesh.owner[ff]) ||
+            (cell == mesh.neighbor[ff]));
+    }
+    return ret && found;
+}
+
+
+//! Reads the mesh in the cwd with a quality report and checks the report
+//! against the metrics of the mesh. The cells are unit cubes or their 6
+//! tets. Prints and counts failures.
+static void
+checkQuality(const char *name, const TestMesh &mesh,
+    const ImportOptions &options, FoamTaskPool *pool, FOAM_UINT32 &numFailed)
+{
+    const bool isHex = (4 == mesh.faces[0].size());
+    DoubleArray1 areas;
+    for (size_t ff = 0; ff < mesh.faces.size(); ++ff) {
+        const FoamPoint n = normal(mesh.pts, &mesh.faces[ff][0],
+            static_cast<FOAM_UINT32>(mesh.faces[ff].size()));
+        areas.push_back(0.5 * std::sqrt(dot(n, n)));
+    }
+    DoubleArray1 nonOrtho(mesh.numInternal);
+    DoubleArray1 skew(mesh.numInternal);
+    for (size_t ff = 0; ff < mesh.numInternal; ++ff) {
+        faceMetrics(mesh, ff, nonOrtho[ff], skew[ff]);
+    }
+    const double vol = isHex ? 1.0 : 1.0 / 6.0;
+    MockHandler handler(mesh);
+    PolyMeshReader reader(options, pool);
+    bool ret = reader.read(handler) && handler.getError().empty();
+    const std::string report(readFile(options.qualityReport.c_str()));
+    double val;
+    unsigned long item;
+    ret = ret && reportVal(report, "face area", "min", val, item) &&
+        isNear(val, *std::min_element(areas.begin(), areas.end())) &&
+        (item < areas.size()) && isNear(areas[item], val) &&
+        reportVal(report, "face area", "max", val, item) &&
+        isNear(val, *std::max_element(areas.begin(), areas.end())) &&
+        (item < areas.size()) && isNear(areas[item], val) &&
+        reportVal(report, "cell volume", "min", val, item) &&
+        isNear(val, vol) && (item < mesh.cellCentres.size()) &&
+        reportVal(report, "cell volume", "max", val, item) &&
+        isNear(val, vol) && (std::string::npos !=
+            report.find("negative volumes  0\n")) &&
+        checkWorst(mesh, report, "non-orthogonality (deg)", nonOrtho) &&
+        checkWorst(mesh, report, "skewness", skew);
+    std::printf("%-4s %-24s %s\n", isHex ? "hex" : "tet", name,
+        ret ? "ok" : "FAILED");
+    numFailed += ret ? 0 : 1;
+}
+
+
+int
+main()
+{
+    FOAM_UINT32 numFailed = 0;
+    FoamTaskPool pool(4);
+    for (int tets = 0; tets < 2; ++tets) {
+        // More faces than PolyMeshHandler::BatchSize
+        const TestMesh mesh(12, 0 != tets);
+        if (!mesh.write()) {
+            std::printf("cannot write the mesh files\n");
+            return 1;
+        }
+        ImportOptions options;
+        runCase("default", mesh, options, 0, numFailed);
+        runCase("pool", mesh, options, &pool, numFailed);
+        options.preloadMB = 0;
+        runCase("lockstep", mesh, options, 0, numFailed);
+        options = ImportOptions();
+        options.prescan = true;
+        runCase("prescan", mesh, options, &pool, numFailed);
+        checkPrescan(mesh, &pool, numFailed);
+        options = ImportOptions();
+        options.cellOrder = true;
+        runCase("cell order", mesh, options, &pool, numFailed);
+        options = ImportOptions();
+        options.compactPoints = true;
+        runCase("compact points", mesh, options, &pool, numFailed);
+        options.preloadMB = 0;
+        runCase("compact lockstep", mesh, options, &pool, numFailed);
+        options.preloadMB = ImportOptions().preloadMB;
+        options.cellOrder = true;
+        options.arena = true;
+        runCase("arena", mesh, options, &pool, numFailed);
+        options = ImportOptions();
+        options.qualityReport = "quality.txt";
+        checkQuality("quality", mesh, options, &pool, numFailed);
+        checkQuality("serial quality", mesh, options, 0, numFailed);
+        // The faces are pushed by cell but reported by file index
+        options.cellOrder = true;
+        checkQuality("cell order quality", mesh, options, &pool, numFailed);
+        checkCsr(mesh, numFailed);
+        checkCompactor(mesh, numFailed);
+        checkZones(mesh, numFailed);
+        checkArchive(mesh, numFailed);
+        checkProbe(mesh, numFailed);
+
+        // Each parallel stage must stop cleanly when cancelled
+        options = ImportOptions();
+        options.prescan = true;
+        checkCancel("cancel prescan", mesh, options, &pool, numFailed);
+        options = ImportOptions();
+        options.cellOrder = true;
+        checkCancel("cancel adjacency", mesh, options, &pool, numFailed);
+        options = ImportOptions();
+        options.compactPoints = true;
+        checkCancel("cancel compact", mesh, options, &pool, numFailed);
+        options = ImportOptions();
+        options.qualityReport = "quality.txt";
+        checkCancel("cancel quality", mesh, options, &pool, numFailed);
+        checkCancel("cancel serial quality", mesh, options, 0, numFailed);
+        checkCollated(mesh, &pool, numFailed);
+        if (!mesh.writeCollated()) {
+            std::printf("cannot write the collated mesh files\n");
+            return 1;
+        }
+        checkCancel("cancel collated", mesh, ImportOptions(), &pool,
+            numFailed);
+        checkCancel("cancel serial collated", mesh, ImportOptions(), 0,
+            numFailed);
+    }
+    std::printf("%lu failed\n", static_cast<unsigned long>(numFailed));
+    return (0 == numFailed) ? 0 : 1;
+}
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/